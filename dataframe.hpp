@@ -3,14 +3,30 @@
  * @class    dataframe
  * @brief    ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  *           read from csv file
+ *           read a csv file larger than memory batch by batch
+ *           lazy csv queries with filter and column pushdown
  *           write into csv file and lib_svm file
- *           min max scaler and standard scaler for each column's data
- *           append one row from std::vector & remove row
+ *           save into and load from binary columnar snapshot
+ *           min max scaler and standard scaler for each column's data, applied in parallel
+ *           append one row from std::vector & remove row, filter rows by a mask in one pass
+ *           append blocks of rows or of structs, transposed into the columns tile by tile
  *           insert one column from std::vector & remove column
- *           get a row of data by index of the row
+ *           get a row of data by index of the row, as a view that does not allocate
  *           get a column of data by string of the column
+ *           views of a row range and some columns without copying (head, tail, slice, select)
  *           concat & add double dataFrame object (horizontally & vertically)
+ *           inner and left hash joins
+ *           multi-key sort with radix sort for numbers
+ *           hash and sorted secondary indexes for lookups and ranges
  *           support single variable with multiple types, including char, int, long int, float, double, std::string
+ *           store each column in one contiguous buffer of its physical type
+ *           copies share the column buffers until one of them writes (copy on write)
+ *           string columns stored as one block of bytes plus offsets
+ *           categorical string columns stored as dictionary codes
+ *           missing values kept in a validity bitmap per column
+ *           memory usage per column and per frame, shrink_to_fit and compact
+ *           vectorized column aggregations and describe
+ *           hash group by with aggregations
  *           ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  * @details
  * @author   Flame
@@ -21,6 +37,11 @@
 #define DATAFRAME_H
 
 #include <cmath>
+#include <cfloat>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <utility>
 #include <vector>
 #include <string>
@@ -28,11 +49,36 @@
 #include <iomanip>
 #include <sstream>
 #include <variant>
+#include <charconv>
+#include <string_view>
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <mutex>
 #include <exception>
+#include <functional>
+#include <iterator>
 #include <algorithm>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include <limits>
 #include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// the aggregation kernels have SSE2 and AVX2 versions on x86-64 with gcc or clang, picked at runtime
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define FLAME_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 #define max_number_bit 50
 
@@ -49,7 +95,7 @@ enum str_type{
 
 class isNumeric {
 public:
-    str_type operator()(const std::string &str) {
+    str_type operator()(std::string_view str) {
         index = 0;
         str_type type = string_type;
 
@@ -79,13 +125,13 @@ public:
 private:
     unsigned int index = 0;
 
-    bool scan_integer(const std::string &str) {
+    bool scan_integer(std::string_view str) {
         if (index < str.size() && (str[index] == '+' || str[index] == '-'))
             index++;
         return scan_unsigned_integer(str);
     }
 
-    bool scan_unsigned_integer(const std::string &str) {
+    bool scan_unsigned_integer(std::string_view str) {
         unsigned int start = index;
         while (index < str.size() && str[index] >= '0' && str[index] <= '9')
             index++;
@@ -93,8 +139,9 @@ private:
     }
 };
 
-str_type get_string_type(const std::string & str){
-    static isNumeric isnumeric;
+str_type get_string_type(std::string_view str){
+    //one per thread, as the chunks of a csv file are parsed in parallel
+    static thread_local isNumeric isnumeric;
     //directly return string_type while str.size() exceeds max_number_bit
     if(str.size() > max_number_bit)
         return string_type;
@@ -118,10 +165,10 @@ public:
 };
 
 template<typename T>
-bool is_numeric_type(){
-    if( is_same_type< T , double> () || is_same_type< T , float>() ||
-        is_same_type< T , int> () || is_same_type< T , long int>() ||
-        is_same_type< T , long long int> () ) return true;
+constexpr bool is_numeric_type(){
+    if( std::is_same_v< T , double> || std::is_same_v< T , float> ||
+        std::is_same_v< T , int> || std::is_same_v< T , long int> ||
+        std::is_same_v< T , long long int> ) return true;
     else return false;
 }
 
@@ -171,367 +218,3342 @@ namespace flame {
                 std::string str_;
                 std::stringstream convert;
             };
-        }
 
-    template<typename T = user_variant>
-    class dataframe {
-    public:
-        class column_array {
-            typedef typename std::vector<T>::const_iterator const_iter;
-            typedef typename std::vector<T>::iterator iter;
-            std::vector<T> *array = nullptr;
-        public:
-            explicit column_array(int n = 0) {
-                array = new std::vector<T>(n);
+            // read-only view of a whole file, mapped into memory when the platform allows it
+            class mapped_file {
+            public:
+                explicit mapped_file(const std::string &filename) {
+#if defined(__unix__) || defined(__APPLE__)
+                    int fd = ::open(filename.c_str(), O_RDONLY);
+                    if (fd < 0)
+                        throw (std::invalid_argument(filename + " is invalid!"));
+                    struct stat status{};
+                    if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+                        void *address = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                        if (address != MAP_FAILED) {
+                            ::madvise(address, status.st_size, MADV_SEQUENTIAL);
+                            mapped = address;
+                            data_ = static_cast<const char *>(address);
+                            size_ = status.st_size;
+                        }
+                    }
+                    ::close(fd);
+                    if (mapped != nullptr || (S_ISREG(status.st_mode) && status.st_size == 0))
+                        return;
+#endif
+                    // pipes and platforms without mmap are read into a buffer
+                    std::ifstream reader(filename, std::ios::in | std::ios::binary);
+                    if (!reader)
+                        throw (std::invalid_argument(filename + " is invalid!"));
+                    std::stringstream content;
+                    content << reader.rdbuf();
+                    buffer = content.str();
+                    data_ = buffer.data();
+                    size_ = buffer.size();
+                }
+
+                mapped_file(const mapped_file &) = delete;
+
+                mapped_file &operator=(const mapped_file &) = delete;
+
+                ~mapped_file() {
+#if defined(__unix__) || defined(__APPLE__)
+                    if (mapped != nullptr)
+                        ::munmap(mapped, size_);
+#endif
+                }
+
+                [[nodiscard]] const char *data() const {
+                    return data_;
+                }
+
+                [[nodiscard]] unsigned long long int size() const {
+                    return size_;
+                }
+
+            private:
+                void *mapped = nullptr;
+                const char *data_ = nullptr;
+                unsigned long long int size_ = 0;
+                std::string buffer;
+            };
+
+            // parse the whole string as one number, false when anything is left or the number is out of range
+            template<typename U>
+            bool parse_exact(std::string_view str, U &value) {
+                if (str.size() > 1 && str.front() == '+' && str[1] != '-')
+                    str.remove_prefix(1);
+                auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+                return !str.empty() && result.ec == std::errc() && result.ptr == str.data() + str.size();
             }
 
-            column_array(const column_array &_array) {
-                array = new std::vector<T>(*_array.array);
+            // the same as reading a long int by std::stringstream, out of range values are saturated
+            inline long int parse_integer(std::string_view str) {
+                if (!str.empty() && str.front() == '+')
+                    str.remove_prefix(1);
+                long int value = 0;
+                auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+                if (result.ec == std::errc::result_out_of_range)
+                    value = str.front() == '-' ? LONG_MIN : LONG_MAX;
+                return value;
             }
 
-            column_array(column_array &&_array) noexcept {
-                array = new std::vector<T>(std::move(*_array.array));
+            // the same as reading a double by std::stringstream, overflow is saturated
+            inline double parse_floating(std::string_view str) {
+                if (!str.empty() && str.front() == '+')
+                    str.remove_prefix(1);
+                double value = 0;
+                auto result = std::from_chars(str.data(), str.data() + str.size(), value);
+                if (result.ec == std::errc::result_out_of_range) {
+                    value = std::strtod(std::string(str).c_str(), nullptr);
+                    if (std::isinf(value))
+                        value = value > 0 ? DBL_MAX : -DBL_MAX;
+                }
+                return value;
             }
 
-            explicit column_array(std::vector<T> &&_array) {
-                array = new std::vector<T>(_array);
+            // append values to a text buffer, numbers are formatted the same as std::ostream with default flags
+            inline void append_value(std::string &buffer, char value) {
+                buffer.push_back(value);
             }
 
-            explicit column_array(const std::vector<T> &_array) {
-                array = new std::vector<T>(_array);
+            inline void append_value(std::string &buffer, int value) {
+                char temp[16];
+                buffer.append(temp, std::to_chars(temp, temp + sizeof(temp), value).ptr - temp);
             }
 
-            ~column_array() {
-                delete array;
+            inline void append_value(std::string &buffer, long int value) {
+                char temp[24];
+                buffer.append(temp, std::to_chars(temp, temp + sizeof(temp), value).ptr - temp);
             }
 
-            void insert(const_iter position, const_iter start, const_iter end) {
-                array->insert(position, start, end);
+            inline void append_value(std::string &buffer, float value) {
+                char temp[32];
+                buffer.append(temp, std::to_chars(temp, temp + sizeof(temp), value,
+                                                  std::chars_format::general, 6).ptr - temp);
             }
 
-            [[nodiscard]] unsigned long long int size() const {
-                if (array == nullptr)
-                    return 0;
-                return array->size();
+            inline void append_value(std::string &buffer, double value) {
+                char temp[32];
+                buffer.append(temp, std::to_chars(temp, temp + sizeof(temp), value,
+                                                  std::chars_format::general, 6).ptr - temp);
             }
 
-            [[nodiscard]] const_iter begin() const {
-                return array->begin();
+            inline void append_value(std::string &buffer, std::string_view value) {
+                buffer.append(value);
             }
 
-            [[nodiscard]] const_iter end() const {
-                return array->end();
+            inline void append_value(std::string &buffer, const std::string &value) {
+                buffer.append(value);
             }
 
-            [[nodiscard]] iter begin() {
-                return array->begin();
+            inline void append_value(std::string &buffer, const user_variant &value) {
+                std::visit([&buffer](const auto &item) { append_value(buffer, item); }, value);
             }
 
-            [[nodiscard]] iter end() {
-                return array->end();
+            // bytes a value keeps on the heap, a string longer than its inline buffer keeps its characters there
+            template<typename U>
+            unsigned long long int heap_bytes(const U &) {
+                return 0;
             }
 
-            void erase(const_iter i) {
-                array->erase(i);
+            inline unsigned long long int heap_bytes(const std::string &value) {
+                return value.capacity() > std::string().capacity() ? value.capacity() + 1 : 0;
             }
 
-            void emplace_back(const T &item) {
-                array->emplace_back(item);
+            template<typename... Ts>
+            unsigned long long int heap_bytes(const std::variant<Ts...> &value) {
+                return std::visit([](const auto &item) { return heap_bytes(item); }, value);
             }
 
-            column_array &operator=(const column_array &other) {
-                if (this != &other) {
-                    if (other.size() == array->size()) {
-                        array->clear();
-                        array->insert(array->begin(), other.begin(), other.end());
-                        return *this;
-                    } else throw (std::invalid_argument("The length of the two is not the same"));
-                }
-                return *this;
+            // append values to a binary buffer in native byte order
+            template<typename U>
+            void append_binary(std::string &buffer, const U &value) {
+                buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
             }
 
-            column_array &operator=(const std::vector<T> &_array) {
-                if (_array.size() == array->size()) {
-                    array->clear();
-                    array->insert(array->begin(), _array.begin(), _array.end());
-                    return *this;
-                }
-                throw (std::invalid_argument("The length of the two is not the same"));
+            inline void append_binary(std::string &buffer, const std::string &value) {
+                append_binary(buffer, (unsigned long long int) value.size());
+                buffer.append(value);
             }
 
-            column_array &operator=(std::vector<T> &&_array) {
-                if (_array.size() == array->size()) {
-                    *array = _array;
-                    return *this;
-                }
-                throw (std::invalid_argument("The length of the two is not the same"));
+            // one byte of the alternative, followed by the value
+            inline void append_binary(std::string &buffer, const user_variant &value) {
+                buffer.push_back(char(value.index()));
+                std::visit([&buffer](const auto &item) { append_binary(buffer, item); }, value);
             }
 
-            [[maybe_unused]] [[nodiscard]] const std::vector<T> &get_std_vector() const {
-                return *array;
+            template<typename U>
+            bool read_binary(const char *data, unsigned long long int size, unsigned long long int &position,
+                             U &value) {
+                if (size < sizeof(value) || position > size - sizeof(value))
+                    return false;
+                std::memcpy(&value, data + position, sizeof(value));
+                position += sizeof(value);
+                return true;
             }
 
-            [[maybe_unused]] std::vector<T> &get_std_vector() {
-                return *array;
+            inline bool read_binary(const char *data, unsigned long long int size, unsigned long long int &position,
+                                    std::string &value) {
+                unsigned long long int n;
+                if (!read_binary(data, size, position, n) || n > size - position)
+                    return false;
+                value.assign(data + position, n);
+                position += n;
+                return true;
             }
 
-            const T &operator[](unsigned long long int i) const {
-                if (i < array->size())
-                    return (*array)[i];
-                else {
-                    std::stringstream ssTemp;
-                    ssTemp << i;
-                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            inline bool read_binary(const char *data, unsigned long long int size, unsigned long long int &position,
+                                    user_variant &value) {
+                if (position >= size)
+                    return false;
+                switch (data[position++]) {
+                    case 0: value = char(); break;
+                    case 1: value = int(); break;
+                    case 2: value = (long int) 0; break;
+                    case 3: value = float(); break;
+                    case 4: value = double(); break;
+                    case 5: value = std::string(); break;
+                    default: return false;
                 }
+                return std::visit([&](auto &item) { return read_binary(data, size, position, item); }, value);
             }
 
-            T &operator[](unsigned long long int i) {
-                if (i < array->size())
-                    return (*array)[i];
-                else {
-                    std::stringstream ssTemp;
-                    ssTemp << i;
-                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
-                }
+            // the first word of a string, the same as reading a std::string by std::stringstream
+            inline std::string_view first_token(std::string_view str) {
+                auto is_space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+                unsigned long long int begin = 0;
+                while (begin < str.size() && is_space(str[begin]))
+                    ++begin;
+                unsigned long long int end = begin;
+                while (end < str.size() && !is_space(str[end]))
+                    ++end;
+                return str.substr(begin, end - begin);
             }
 
-            friend std::ostream &operator<<(std::ostream &cout, column_array &arr) {
-                for (const auto &item : *arr.array) {
-                    cout << item << ' ';
+            // run function(task) for every task in [0, tasks) on up to threads threads (0 means all cores),
+            // the first exception of a task is thrown again once every thread has finished
+            template<typename Function>
+            void parallel_for(unsigned long long int tasks, unsigned int threads, Function &&function) {
+                if (threads == 0)
+                    threads = std::max(1u, std::thread::hardware_concurrency());
+                threads = (unsigned int) std::min<unsigned long long int>(threads, tasks);
+                if (threads <= 1) {
+                    for (unsigned long long int task = 0; task < tasks; ++task)
+                        function(task);
+                    return;
                 }
-                return cout;
+                std::vector<std::exception_ptr> errors(threads);
+                std::vector<std::thread> workers;
+                for (unsigned int k = 0; k < threads; ++k) {
+                    workers.emplace_back([&, k]() {
+                        try {
+                            for (unsigned long long int task = k; task < tasks; task += threads)
+                                function(task);
+                        } catch (...) {
+                            errors[k] = std::current_exception();
+                        }
+                    });
+                }
+                for (auto &worker : workers)
+                    worker.join();
+                for (auto &error : errors)
+                    if (error)
+                        std::rethrow_exception(error);
             }
-        };
 
-        class row_array {
-            typedef typename std::vector<T *>::const_iterator const_iter;
-            typedef typename std::vector<T *>::iterator iter;
-            std::vector<T *> *array = nullptr;
-        public:
-            explicit row_array(int n = 0) {
-                array = new std::vector<T *>(n);
+            // key of a number whose unsigned order is the order of the numbers
+            template<typename U>
+            inline std::uint64_t order_key(U value) {
+                if constexpr (std::is_floating_point_v<U>) {
+                    double number = value;
+                    std::uint64_t bits;
+                    std::memcpy(&bits, &number, sizeof(bits));
+                    return (bits >> 63) != 0 ? ~bits : bits | (std::uint64_t(1) << 63);
+                } else return std::uint64_t((long long int) value) ^ (std::uint64_t(1) << 63);
             }
 
-            row_array(const row_array &_array) {
-                array = new std::vector<T *>(*_array.array);
+            // stable LSD radix sort of rows by keys, one byte per pass, the passes where every key has
+            // the same byte are skipped
+            inline void radix_sort(std::vector<std::uint64_t> &keys, std::vector<unsigned long long int> &rows) {
+                const unsigned long long int n = keys.size();
+                if (n < 2)
+                    return;
+                // the counts of every pass are taken in one read of the keys
+                std::vector<unsigned long long int> counts(8 * 256, 0);
+                for (auto key : keys) {
+                    for (unsigned int pass = 0; pass < 8; ++pass)
+                        ++counts[pass * 256 + (key >> (pass * 8) & 0xff)];
+                }
+                std::vector<std::uint64_t> next_keys(n);
+                std::vector<unsigned long long int> next_rows(n);
+                for (unsigned int pass = 0; pass < 8; ++pass) {
+                    unsigned long long int *count = counts.data() + pass * 256;
+                    const unsigned int shift = pass * 8;
+                    if (count[keys[0] >> shift & 0xff] == n)
+                        continue;
+                    unsigned long long int offset = 0;
+                    for (unsigned int k = 0; k < 256; ++k) {
+                        auto size = count[k];
+                        count[k] = offset;
+                        offset += size;
+                    }
+                    for (unsigned long long int i = 0; i < n; ++i) {
+                        auto k = count[keys[i] >> shift & 0xff]++;
+                        next_keys[k] = keys[i];
+                        next_rows[k] = rows[i];
+                    }
+                    keys.swap(next_keys);
+                    rows.swap(next_rows);
+                }
             }
 
-            row_array(row_array &&_array) noexcept {
-                array = new std::vector<T *>(std::move(*_array.array));
+            // stable merge sort of rows, chunks are sorted by up to threads threads (0 means all cores)
+            // and merged pairwise
+            template<typename Compare>
+            void parallel_stable_sort(std::vector<unsigned long long int> &rows, Compare &&compare,
+                                      unsigned int threads) {
+                if (threads == 0)
+                    threads = std::max(1u, std::thread::hardware_concurrency());
+                const unsigned long long int min_chunk = 1 << 14;
+                const unsigned long long int chunks =
+                        std::max<unsigned long long int>(1, std::min<unsigned long long int>(threads,
+                                                                                            rows.size() / min_chunk));
+                const unsigned long long int chunk_size = (rows.size() + chunks - 1) / chunks;
+                auto bound = [&](unsigned long long int chunk) {
+                    return rows.begin() + (long long int) std::min<unsigned long long int>(rows.size(),
+                                                                                          chunk * chunk_size);
+                };
+                parallel_for(chunks, threads, [&](unsigned long long int chunk) {
+                    std::stable_sort(bound(chunk), bound(chunk + 1), compare);
+                });
+                for (unsigned long long int step = 1; step < chunks; step *= 2) {
+                    parallel_for((chunks + 2 * step - 1) / (2 * step), threads, [&](unsigned long long int pair) {
+                        unsigned long long int first = pair * 2 * step;
+                        std::inplace_merge(bound(first), bound(std::min(chunks, first + step)),
+                                           bound(std::min(chunks, first + 2 * step)), compare);
+                    });
+                }
             }
 
-            [[maybe_unused]] explicit row_array(std::vector<T *> &&_array) {
-                array = new std::vector<T *>(_array);
+            // count, sum, min and max of the numbers of a column, integers are summed in 64 bits
+            template<typename U>
+            struct reduction {
+                typedef std::conditional_t<std::is_integral_v<U>, long long int, double> sum_type;
+                unsigned long long int count = 0;
+                sum_type sum = 0;
+                U min = std::numeric_limits<U>::max();
+                U max = std::numeric_limits<U>::lowest();
+            };
+
+            // count, mean, sum of squared deviations, min and max of numbers, two of them computed on different
+            // rows merge into the moments of all rows (Welford's update and Chan's merge)
+            struct moments {
+                unsigned long long int cells = 0;  // values which are not missing, words included
+                unsigned long long int count = 0;  // numbers
+                double mean = 0;
+                double m2 = 0;
+                double min = std::numeric_limits<double>::infinity();
+                double max = -std::numeric_limits<double>::infinity();
+
+                void push(double value) {
+                    ++count;
+                    double delta = value - mean;
+                    mean += delta / count;
+                    m2 += delta * (value - mean);
+                    min = value < min ? value : min;
+                    max = value > max ? value : max;
+                }
+
+                void merge(const moments &other) {
+                    cells += other.cells;
+                    if (other.count == 0)
+                        return;
+                    if (count == 0) {
+                        count = other.count;
+                        mean = other.mean;
+                        m2 = other.m2;
+                        min = other.min;
+                        max = other.max;
+                        return;
+                    }
+                    double total = double(count) + double(other.count);
+                    double delta = other.mean - mean;
+                    mean += delta * (double(other.count) / total);
+                    m2 += other.m2 + delta * delta * (double(count) * double(other.count) / total);
+                    count += other.count;
+                    min = other.min < min ? other.min : min;
+                    max = other.max > max ? other.max : max;
+                }
+            };
+
+            // portable kernels, also used for the values left over by the vector kernels
+            template<typename U>
+            inline void reduce_scalar(const U *data, unsigned long long int n, reduction<U> &result) {
+                for (unsigned long long int i = 0; i < n; ++i) {
+                    result.sum += data[i];
+                    result.min = data[i] < result.min ? data[i] : result.min;
+                    result.max = data[i] > result.max ? data[i] : result.max;
+                }
+                result.count += n;
             }
 
-            [[maybe_unused]] explicit row_array(const std::vector<T *> &_array) {
-                array = new std::vector<T *>(_array);
+            template<typename U>
+            inline double deviations_scalar(const U *data, unsigned long long int n, double mean) {
+                double sum = 0;
+                for (unsigned long long int i = 0; i < n; ++i)
+                    sum += (double(data[i]) - mean) * (double(data[i]) - mean);
+                return sum;
             }
 
-            ~row_array() {
-                delete array;
+#ifdef FLAME_X86_KERNELS
+            // the vector kernels handle the longest prefix of whole steps and return its length,
+            // min and max keep the accumulated value when a value is NaN, like the scalar kernels
+            inline bool has_avx2() {
+                static const bool supported = __builtin_cpu_supports("avx2");
+                return supported;
             }
 
-            void insert(const_iter position, const_iter start, const_iter end) {
-                array->insert(position, start, end);
+            __attribute__((target("avx2"))) inline double horizontal_sum(__m256d value) {
+                __m128d half = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+                return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
             }
 
-            [[nodiscard]] unsigned long long int size() const {
-                if (array == nullptr)
-                    return 0;
-                return array->size();
+            inline double horizontal_sum(__m128d value) {
+                return _mm_cvtsd_f64(_mm_add_sd(value, _mm_unpackhi_pd(value, value)));
             }
 
-            [[nodiscard]] const_iter begin() const {
-                return array->begin();
+            // add the lanes of the vector accumulators into result
+            template<typename U, typename Sum, typename Extreme>
+            inline void merge_lanes(const Sum &sum, const Extreme &min, const Extreme &max, unsigned long long int n,
+                                    reduction<U> &result) {
+                U mins[sizeof(Extreme) / sizeof(U)], maxs[sizeof(Extreme) / sizeof(U)];
+                std::memcpy(mins, &min, sizeof(Extreme));
+                std::memcpy(maxs, &max, sizeof(Extreme));
+                for (unsigned int j = 0; j < sizeof(Extreme) / sizeof(U); ++j) {
+                    result.min = mins[j] < result.min ? mins[j] : result.min;
+                    result.max = maxs[j] > result.max ? maxs[j] : result.max;
+                }
+                typename reduction<U>::sum_type sums[sizeof(Sum) / sizeof(typename reduction<U>::sum_type)];
+                std::memcpy(sums, &sum, sizeof(Sum));
+                for (auto item : sums)
+                    result.sum += item;
+                result.count += n;
             }
 
-            [[nodiscard]] const_iter end() const {
-                return array->end();
+            __attribute__((target("avx2"))) inline unsigned long long int
+            reduce_avx2(const double *data, unsigned long long int n, reduction<double> &result) {
+                __m256d sum0 = _mm256_setzero_pd(), sum1 = sum0;
+                __m256d min0 = _mm256_set1_pd(result.min), min1 = min0;
+                __m256d max0 = _mm256_set1_pd(result.max), max1 = max0;
+                unsigned long long int i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256d a = _mm256_loadu_pd(data + i), b = _mm256_loadu_pd(data + i + 4);
+                    sum0 = _mm256_add_pd(sum0, a);
+                    sum1 = _mm256_add_pd(sum1, b);
+                    min0 = _mm256_min_pd(a, min0);
+                    min1 = _mm256_min_pd(b, min1);
+                    max0 = _mm256_max_pd(a, max0);
+                    max1 = _mm256_max_pd(b, max1);
+                }
+                merge_lanes(_mm256_add_pd(sum0, sum1), _mm256_min_pd(min0, min1), _mm256_max_pd(max0, max1), i,
+                            result);
+                return i;
             }
 
-            [[nodiscard]] iter begin() {
-                return array->begin();
+            __attribute__((target("avx2"))) inline unsigned long long int
+            reduce_avx2(const float *data, unsigned long long int n, reduction<float> &result) {
+                __m256d sum0 = _mm256_setzero_pd(), sum1 = sum0;
+                __m256 min = _mm256_set1_ps(result.min), max = _mm256_set1_ps(result.max);
+                unsigned long long int i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256 a = _mm256_loadu_ps(data + i);
+                    sum0 = _mm256_add_pd(sum0, _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+                    sum1 = _mm256_add_pd(sum1, _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+                    min = _mm256_min_ps(a, min);
+                    max = _mm256_max_ps(a, max);
+                }
+                merge_lanes(_mm256_add_pd(sum0, sum1), min, max, i, result);
+                return i;
             }
 
-            [[nodiscard]] iter end() {
-                return array->end();
+            // 32 bit integers are summed in 64 bit lanes
+            __attribute__((target("avx2"))) inline unsigned long long int
+            reduce_avx2_int32(const void *data, unsigned long long int n, __m256i &sum, __m256i &min, __m256i &max) {
+                unsigned long long int i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data) + i / 8);
+                    sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(a)));
+                    sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(a, 1)));
+                    min = _mm256_min_epi32(a, min);
+                    max = _mm256_max_epi32(a, max);
+                }
+                return i;
             }
 
-            row_array &operator=(const row_array &other) {
-                if (this != &other) {
-                    if (other.size() == array->size()) {
-                        for (int i = 0; i < other.size(); ++i) {
-                            *(*array)[i] = other[i];
-                        }
-                        return *this;
-                    } else throw (std::invalid_argument("The length of the two is not the same"));
+            __attribute__((target("avx2"))) inline unsigned long long int
+            reduce_avx2_int64(const void *data, unsigned long long int n, __m256i &sum, __m256i &min, __m256i &max) {
+                unsigned long long int i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data) + i / 4);
+                    sum = _mm256_add_epi64(sum, a);
+                    min = _mm256_blendv_epi8(min, a, _mm256_cmpgt_epi64(min, a));
+                    max = _mm256_blendv_epi8(max, a, _mm256_cmpgt_epi64(a, max));
                 }
-                return *this;
+                return i;
             }
 
-            row_array &operator=(const std::vector<T> &_array) {
-                if (_array.size() == array->size()) {
-                    for (int i = 0; i < _array.size(); ++i) {
-                        *(*array)[i] = _array[i];
-                    }
-                    return *this;
+            template<typename U>
+            __attribute__((target("avx2"))) inline unsigned long long int
+            reduce_avx2(const U *data, unsigned long long int n, reduction<U> &result) {
+                static_assert(std::is_integral_v<U> && (sizeof(U) == 4 || sizeof(U) == 8));
+                __m256i sum = _mm256_setzero_si256();
+                __m256i min, max;
+                unsigned long long int i;
+                if constexpr (sizeof(U) == 4) {
+                    min = _mm256_set1_epi32(result.min);
+                    max = _mm256_set1_epi32(result.max);
+                    i = reduce_avx2_int32(data, n, sum, min, max);
+                } else {
+                    min = _mm256_set1_epi64x(result.min);
+                    max = _mm256_set1_epi64x(result.max);
+                    i = reduce_avx2_int64(data, n, sum, min, max);
                 }
-                throw (std::invalid_argument("The length of the two is not the same"));
+                merge_lanes(sum, min, max, i, result);
+                return i;
             }
 
-            row_array &operator=(std::vector<T> &&_array) {
-                if (_array.size() == array->size()) {
-                    for (int i = 0; i < _array.size(); ++i) {
-                        *(*array)[i] = _array[i];
-                    }
-                    return *this;
+            inline unsigned long long int reduce_sse2(const double *data, unsigned long long int n,
+                                                      reduction<double> &result) {
+                __m128d sum0 = _mm_setzero_pd(), sum1 = sum0;
+                __m128d min0 = _mm_set1_pd(result.min), min1 = min0;
+                __m128d max0 = _mm_set1_pd(result.max), max1 = max0;
+                unsigned long long int i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m128d a = _mm_loadu_pd(data + i), b = _mm_loadu_pd(data + i + 2);
+                    sum0 = _mm_add_pd(sum0, a);
+                    sum1 = _mm_add_pd(sum1, b);
+                    min0 = _mm_min_pd(a, min0);
+                    min1 = _mm_min_pd(b, min1);
+                    max0 = _mm_max_pd(a, max0);
+                    max1 = _mm_max_pd(b, max1);
                 }
-                throw (std::invalid_argument("The length of the two is not the same"));
+                merge_lanes(_mm_add_pd(sum0, sum1), _mm_min_pd(min0, min1), _mm_max_pd(max0, max1), i, result);
+                return i;
             }
 
-            [[maybe_unused]] const std::vector<T *> &get_point_vector() const {
-                return *array;
+            inline unsigned long long int reduce_sse2(const float *data, unsigned long long int n,
+                                                      reduction<float> &result) {
+                __m128d sum0 = _mm_setzero_pd(), sum1 = sum0;
+                __m128 min = _mm_set1_ps(result.min), max = _mm_set1_ps(result.max);
+                unsigned long long int i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m128 a = _mm_loadu_ps(data + i);
+                    sum0 = _mm_add_pd(sum0, _mm_cvtps_pd(a));
+                    sum1 = _mm_add_pd(sum1, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+                    min = _mm_min_ps(a, min);
+                    max = _mm_max_ps(a, max);
+                }
+                merge_lanes(_mm_add_pd(sum0, sum1), min, max, i, result);
+                return i;
             }
 
-            [[maybe_unused]] std::vector<T *> &get_point_vector() {
-                return *array;
+            __attribute__((target("avx2"))) inline unsigned long long int
+            deviations_avx2(const double *data, unsigned long long int n, double mean, double &result) {
+                __m256d center = _mm256_set1_pd(mean), sum0 = _mm256_setzero_pd(), sum1 = sum0;
+                unsigned long long int i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256d a = _mm256_sub_pd(_mm256_loadu_pd(data + i), center);
+                    __m256d b = _mm256_sub_pd(_mm256_loadu_pd(data + i + 4), center);
+                    sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(a, a));
+                    sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(b, b));
+                }
+                result += horizontal_sum(_mm256_add_pd(sum0, sum1));
+                return i;
             }
 
-            [[maybe_unused]] std::vector<T> get_std_vector() const {
-                std::vector<T> result;
-                if (array == nullptr)
-                    throw (std::invalid_argument("This row array is invalid!"));
-                for (T *item : *array) {
-                    result.push_back(*item);
+            __attribute__((target("avx2"))) inline unsigned long long int
+            deviations_avx2(const float *data, unsigned long long int n, double mean, double &result) {
+                __m256d center = _mm256_set1_pd(mean), sum0 = _mm256_setzero_pd(), sum1 = sum0;
+                unsigned long long int i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256 value = _mm256_loadu_ps(data + i);
+                    __m256d a = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(value)), center);
+                    __m256d b = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(value, 1)), center);
+                    sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(a, a));
+                    sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(b, b));
                 }
-                return result;
+                result += horizontal_sum(_mm256_add_pd(sum0, sum1));
+                return i;
             }
 
-            void push_back(T *item) {
-                array->emplace_back(item);
+            __attribute__((target("avx2"))) inline unsigned long long int
+            deviations_avx2(const int *data, unsigned long long int n, double mean, double &result) {
+                __m256d center = _mm256_set1_pd(mean), sum0 = _mm256_setzero_pd(), sum1 = sum0;
+                unsigned long long int i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256d a = _mm256_sub_pd(
+                            _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))), center);
+                    __m256d b = _mm256_sub_pd(
+                            _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 4))),
+                            center);
+                    sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(a, a));
+                    sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(b, b));
+                }
+                result += horizontal_sum(_mm256_add_pd(sum0, sum1));
+                return i;
             }
 
-            const T &operator[](unsigned long long int i) const {
-                if (i < array->size())
-                    return *((*array)[i]);
-                else {
-                    std::stringstream ssTemp;
-                    ssTemp << i;
-                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            inline unsigned long long int deviations_sse2(const double *data, unsigned long long int n, double mean,
+                                                          double &result) {
+                __m128d center = _mm_set1_pd(mean), sum0 = _mm_setzero_pd(), sum1 = sum0;
+                unsigned long long int i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m128d a = _mm_sub_pd(_mm_loadu_pd(data + i), center);
+                    __m128d b = _mm_sub_pd(_mm_loadu_pd(data + i + 2), center);
+                    sum0 = _mm_add_pd(sum0, _mm_mul_pd(a, a));
+                    sum1 = _mm_add_pd(sum1, _mm_mul_pd(b, b));
                 }
+                result += horizontal_sum(_mm_add_pd(sum0, sum1));
+                return i;
             }
+#endif
 
-            T &operator[](unsigned long long int i) {
-                if (i < array->size())
-                    return *((*array)[i]);
-                else {
-                    std::stringstream ssTemp;
-                    ssTemp << i;
-                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            // count, sum, min and max of n contiguous numbers added into result
+            template<typename U>
+            void reduce(const U *data, unsigned long long int n, reduction<U> &result) {
+                unsigned long long int done = 0;
+#ifdef FLAME_X86_KERNELS
+                constexpr bool vector_integer = std::is_integral_v<U> && (sizeof(U) == 4 || sizeof(U) == 8);
+                if constexpr (std::is_floating_point_v<U> || vector_integer) {
+                    if (has_avx2())
+                        done = reduce_avx2(data, n, result);
+                    else if constexpr (std::is_floating_point_v<U>)
+                        done = reduce_sse2(data, n, result);
                 }
+#endif
+                reduce_scalar(data + done, n - done, result);
             }
 
-            friend std::ostream &operator<<(std::ostream &cout, row_array &arr) {
-                for (const auto &item : *arr.array) {
-                    cout << item << ' ';
+            // sum of (x - mean)^2 of n contiguous numbers
+            template<typename U>
+            double deviations(const U *data, unsigned long long int n, double mean) {
+                double result = 0;
+                unsigned long long int done = 0;
+#ifdef FLAME_X86_KERNELS
+                if constexpr (std::is_floating_point_v<U> || std::is_same_v<U, int>) {
+                    if (has_avx2())
+                        done = deviations_avx2(data, n, mean, result);
+                    else if constexpr (std::is_same_v<U, double>)
+                        done = deviations_sse2(data, n, mean, result);
                 }
-                return cout;
+#endif
+                return result + deviations_scalar(data + done, n - done, mean);
             }
-        };
+        }
 
-    private:
-        typedef std::vector<std::string> string_vector;
-        typedef typename std::vector<column_array *>::const_iterator dataframe_const_iter;
-        typedef typename std::vector<column_array *>::iterator dataframe_iter;
-        bool is_scaler = false;
+    // physical layout of one column, the order follows the alternatives of user_variant
+    enum column_type {
+        cell_column = 0,
+        char_column,
+        int_column,
+        long_column,
+        float_column,
+        double_column,
+        string_column,
+        category_column
+    };
+
+    // physical type of columns by name, used when reading csv files
+    typedef std::unordered_map<std::string, column_type> csv_schema;
+
+    // reductions of one column computed by a query, over the values which are not missing
+    enum aggregate_type {
+        count_aggregate = 0,
+        sum_aggregate,
+        mean_aggregate,
+        std_aggregate,
+        min_aggregate,
+        max_aggregate
+    };
+
+    // secondary index of a column: a hash table for equality, or the rows in the order of their values for ranges
+    enum index_type {
+        hash_index = 0,
+        sorted_index
+    };
+
+    // rows kept by a join: matching rows only, or every row of the left dataframe
+    enum join_type {
+        inner_join = 0,
+        left_join
+    };
+
+    // name of the column holding one aggregate of col, such as col_sum
+    inline std::string aggregate_name(const std::string &col, aggregate_type type) {
+        static const char *names[] = {"count", "sum", "mean", "std", "min", "max"};
+        return col + "_" + names[type];
+    }
+
+    // one aggregate from the moments and the sum of the numbers of a column,
+    // NaN for mean, std, min and max when there are too few numbers
+    inline double aggregate_value(const toolbox::moments &stats, double sum, aggregate_type type) {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        switch (type) {
+            case count_aggregate:
+                return double(stats.cells);
+            case sum_aggregate:
+                return sum;
+            case mean_aggregate:
+                return stats.count == 0 ? nan : stats.mean;
+            case std_aggregate:
+                return stats.count < 2 ? nan : std::sqrt(stats.m2 / double(stats.count - 1));
+            case min_aggregate:
+                return stats.count == 0 ? nan : stats.min;
+            case max_aggregate:
+                return stats.count == 0 ? nan : stats.max;
+        }
+        return nan;
+    }
+
+    // bytes held by a column or a dataframe, as reported by memory_usage
+    struct memory_footprint {
+        // the cells in use and their validity bitmap
+        unsigned long long int payload = 0;
+        // capacity reserved beyond the cells in use, which shrink_to_fit releases
+        unsigned long long int slack = 0;
+        // characters of strings, the dictionary of categorical columns and the names of the columns
+        unsigned long long int strings = 0;
+        // secondary indexes
+        unsigned long long int indexes = 0;
+
+        [[nodiscard]] unsigned long long int total() const {
+            return payload + slack + strings + indexes;
+        }
+
+        memory_footprint &operator+=(const memory_footprint &other) {
+            payload += other.payload;
+            slack += other.slack;
+            strings += other.strings;
+            indexes += other.indexes;
+            return *this;
+        }
 
+        // bytes of the elements of a vector in use, and of its capacity beyond them
+        template<typename V>
+        void add(const std::vector<V> &values) {
+            payload += values.size() * sizeof(V);
+            slack += (values.capacity() - values.size()) * sizeof(V);
+        }
+    };
+
+    // contiguous values of one type, either owned or viewed in memory kept alive by an owner (e.g. a mapped file),
+    // a viewed buffer is copied into its own storage before the first modification
+    template<typename U>
+    class column_buffer {
     public:
-        // constructed by file name
-        explicit dataframe(const std::string &filename, const char &delimiter = ',') :
-            dataframe_name(filename), width(0), length(0) {
-            read_csv(filename, delimiter);
+        typedef U value_type;
+        typedef typename std::vector<U>::iterator iterator;
+        typedef const U *const_iterator;
+
+        column_buffer() = default;
+
+        column_buffer(std::vector<U> &&values) : values(std::move(values)) {}
+
+        column_buffer(const U *data, unsigned long long int n, std::shared_ptr<const void> owner) :
+                view(data), view_size(n), owner(std::move(owner)) {}
+
+        [[nodiscard]] unsigned long long int size() const {
+            return owner ? view_size : values.size();
         }
 
-        // constructed by width and length
-        explicit dataframe(unsigned long long int _width = 0, std::string name = "dataframe") :
-            dataframe_name(std::move(name)), width(_width), length(0) {
-            string_vector temp;
-            for (unsigned long long int i = 0; i < _width; i++)
-                temp.emplace_back(std::to_string(i));
-            column_paste(temp);
+        [[nodiscard]] bool empty() const {
+            return size() == 0;
         }
 
-        // constructed by string vector
-        explicit dataframe(const string_vector &columns, std::string name = "dataframe") :
-            dataframe_name(std::move(name)), width(columns.size()), length(0) {
-            column_paste(columns);
+        [[nodiscard]] unsigned long long int capacity() const {
+            return owner ? view_size : values.capacity();
         }
 
-        // copy constructor
-        dataframe(const dataframe &dataframe) :
-                dataframe_name(dataframe.dataframe_name),
-                width(dataframe.width),
-                length(dataframe.length),
-                column(dataframe.column),
-                index(dataframe.index) {
-            matrix.clear();
-            for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
-                matrix.emplace_back(new column_array(**i));
-            }
+        // whether the values are still viewed in memory of the owner
+        [[nodiscard]] bool is_view() const {
+            return owner != nullptr;
         }
 
-        // move constructor
-        dataframe(dataframe &&dataframe) noexcept:
-                dataframe_name(dataframe.dataframe_name),
-                width(dataframe.width),
-                length(dataframe.length),
-                column(std::move(dataframe.column)),
-                index(std::move(dataframe.index)) {
-            matrix.clear();
-            for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
-                matrix.emplace_back(new column_array(std::move(**i)));
-            }
+        [[nodiscard]] const U *data() const {
+            return owner ? view : values.data();
         }
 
-        ~dataframe() {
-            for (auto i = 0; i < matrix.size(); ++i) {
-                delete matrix[i];
-            }
+        U *data() {
+            own();
+            return values.data();
         }
 
-        dataframe_iter begin() {
-            return matrix.begin();
+        const U &operator[](unsigned long long int i) const {
+            return data()[i];
         }
 
-        dataframe_const_iter begin() const {
-            return matrix.begin();
+        U &operator[](unsigned long long int i) {
+            own();
+            return values[i];
         }
 
-        dataframe_iter end() {
-            return matrix.end();
+        [[nodiscard]] const_iterator begin() const {
+            return data();
         }
 
-        dataframe_const_iter end() const {
-            return matrix.end();
+        [[nodiscard]] const_iterator end() const {
+            return data() + size();
         }
 
-        // determine whether the column is included
-        bool contain(const std::string &col) {
-            return index.find(col) != index.end();
+        iterator begin() {
+            own();
+            return values.begin();
         }
 
-        // insert one column
-        bool insert(const std::string &col) {
-            ++width;
-            column.emplace_back(col);
-            index.emplace(col, index.size());
-            matrix.emplace_back(new column_array(length));
-            return true;
+        iterator end() {
+            own();
+            return values.end();
+        }
+
+        template<typename... Args>
+        void emplace_back(Args &&... args) {
+            own();
+            values.emplace_back(std::forward<Args>(args)...);
+        }
+
+        template<typename InputIt>
+        void insert(iterator position, InputIt first, InputIt last) {
+            values.insert(position, first, last);
+        }
+
+        void erase(iterator position) {
+            values.erase(position);
+        }
+
+        void erase(iterator first, iterator last) {
+            values.erase(first, last);
+        }
+
+        void reserve(unsigned long long int n) {
+            own();
+            values.reserve(n);
+        }
+
+        void resize(unsigned long long int n) {
+            own();
+            values.resize(n);
+        }
+
+        // a viewed buffer has no capacity to release and is not copied
+        void shrink_to_fit() {
+            if (!owner)
+                values.shrink_to_fit();
+        }
+
+        // bytes of the values, the ones viewed in memory of the owner are counted as payload
+        [[nodiscard]] memory_footprint memory_usage() const {
+            memory_footprint result;
+            if (owner)
+                result.payload = view_size * sizeof(U);
+            else result.add(values);
+            return result;
+        }
+
+        void clear() {
+            release();
+            values.clear();
+        }
+
+    private:
+        void own() {
+            if (owner) {
+                values.assign(view, view + view_size);
+                release();
+            }
+        }
+
+        void release() {
+            owner.reset();
+            view = nullptr;
+            view_size = 0;
+        }
+
+        std::vector<U> values;
+        const U *view = nullptr;
+        unsigned long long int view_size = 0;
+        std::shared_ptr<const void> owner;
+    };
+
+    // strings of a column kept one after another in a single block of bytes with the offset of every string,
+    // like the utf8 layout of arrow: a cell is read as a std::string_view into the block, appending a string
+    // allocates nothing once the block has room, and the whole block is released at once with the column
+    class string_buffer {
+    public:
+        typedef std::string value_type;
+        typedef unsigned long long int offset_type;
+
+        class const_iterator {
+            const string_buffer *strings = nullptr;
+            unsigned long long int i = 0;
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef std::string_view value_type;
+            typedef long long int difference_type;
+            typedef void pointer;
+            typedef std::string_view reference;
+
+            const_iterator() = default;
+
+            const_iterator(const string_buffer *_strings, unsigned long long int _i) : strings(_strings), i(_i) {}
+
+            std::string_view operator*() const {
+                return (*strings)[i];
+            }
+
+            const_iterator &operator++() {
+                ++i;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator temp(*this);
+                ++i;
+                return temp;
+            }
+
+            friend bool operator==(const const_iterator &a, const const_iterator &b) {
+                return a.i == b.i;
+            }
+
+            friend bool operator!=(const const_iterator &a, const const_iterator &b) {
+                return a.i != b.i;
+            }
+        };
+
+        string_buffer() = default;
+
+        string_buffer(std::vector<std::string> &&values) {
+            unsigned long long int total = 0;
+            for (const auto &item : values)
+                total += item.size();
+            bytes.reserve(total);
+            offsets.reserve(values.size() + 1);
+            for (const auto &item : values)
+                emplace_back(item);
+        }
+
+        // build from the offsets of rows strings, which start at 0 and do not decrease, and their bytes
+        string_buffer(std::vector<offset_type> &&_offsets, std::vector<char> &&_bytes) :
+                bytes(std::move(_bytes)), offsets(std::move(_offsets)) {
+            if (offsets.empty() || offsets.front() != 0 || offsets.back() != bytes.size() ||
+                !std::is_sorted(offsets.begin(), offsets.end()))
+                throw (std::invalid_argument("the offsets of the strings do not match their bytes"));
+        }
+
+        [[nodiscard]] unsigned long long int size() const {
+            return offsets.size() - 1;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return size() == 0;
+        }
+
+        [[nodiscard]] unsigned long long int capacity() const {
+            return offsets.capacity() - 1;
+        }
+
+        std::string_view operator[](unsigned long long int i) const {
+            return {bytes.data() + offsets[i], offsets[i + 1] - offsets[i]};
+        }
+
+        [[nodiscard]] const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        [[nodiscard]] const_iterator end() const {
+            return const_iterator(this, size());
+        }
+
+        // the bytes of all strings, and the offset where every string begins followed by the size of the bytes
+        [[nodiscard]] const std::vector<char> &chars() const {
+            return bytes;
+        }
+
+        [[nodiscard]] const std::vector<offset_type> &get_offsets() const {
+            return offsets;
+        }
+
+        void emplace_back(std::string_view value) {
+            if (overlaps(value)) {
+                emplace_back(std::string(value));
+                return;
+            }
+            bytes.insert(bytes.end(), value.begin(), value.end());
+            offsets.emplace_back(bytes.size());
+        }
+
+        // a string of another size moves the bytes of the cells after it
+        void set(unsigned long long int i, std::string_view value) {
+            if (overlaps(value)) {
+                set(i, std::string(value));
+                return;
+            }
+            auto begin = offsets[i], end = offsets[i + 1];
+            if (value.size() == end - begin) {
+                std::copy(value.begin(), value.end(), bytes.begin() + begin);
+                return;
+            }
+            bytes.erase(bytes.begin() + begin, bytes.begin() + end);
+            bytes.insert(bytes.begin() + begin, value.begin(), value.end());
+            shift(i + 1, (long long int) value.size() - (long long int) (end - begin));
+        }
+
+        void erase(unsigned long long int i) {
+            auto begin = offsets[i], end = offsets[i + 1];
+            bytes.erase(bytes.begin() + begin, bytes.begin() + end);
+            offsets.erase(offsets.begin() + i);
+            shift(i, -(long long int) (end - begin));
+        }
+
+        // keep the cells whose flag is true, the bytes are moved down in a single pass
+        void filter(const std::vector<bool> &keep) {
+            offset_type position = 0;
+            unsigned long long int k = 0;
+            for (unsigned long long int i = 0; i < size(); ++i) {
+                if (!keep[i])
+                    continue;
+                auto begin = offsets[i], end = offsets[i + 1];
+                if (position != begin)
+                    std::memmove(bytes.data() + position, bytes.data() + begin, end - begin);
+                position += end - begin;
+                offsets[++k] = position;
+            }
+            offsets.resize(k + 1);
+            bytes.resize(position);
+        }
+
+        // append the cells of another buffer, its bytes are copied in one block
+        void append(const string_buffer &other) {
+            auto base = offset_type(bytes.size());
+            bytes.insert(bytes.end(), other.bytes.begin(), other.bytes.end());
+            offsets.reserve(offsets.size() + other.size());
+            for (unsigned long long int i = 1; i < other.offsets.size(); ++i)
+                offsets.emplace_back(base + other.offsets[i]);
+        }
+
+        // the cells in rows [begin, end)
+        [[nodiscard]] string_buffer slice(unsigned long long int begin, unsigned long long int end) const {
+            string_buffer result;
+            result.bytes.assign(bytes.begin() + offsets[begin], bytes.begin() + offsets[end]);
+            result.offsets.reserve(end - begin + 1);
+            for (unsigned long long int i = begin + 1; i <= end; ++i)
+                result.offsets.emplace_back(offsets[i] - offsets[begin]);
+            return result;
+        }
+
+        // room for n cells, the bytes are reserved at the average size of the cells already held
+        void reserve(unsigned long long int n) {
+            if (!empty() && n > size())
+                bytes.reserve(bytes.size() + (n - size()) * (bytes.size() / size()));
+            offsets.reserve(n + 1);
+        }
+
+        void shrink_to_fit() {
+            bytes.shrink_to_fit();
+            offsets.shrink_to_fit();
+        }
+
+        // the offsets are the payload and the bytes are counted as strings
+        [[nodiscard]] memory_footprint memory_usage() const {
+            memory_footprint result;
+            result.add(offsets);
+            result.strings = bytes.size();
+            result.slack += bytes.capacity() - bytes.size();
+            return result;
+        }
+
+        void clear() {
+            bytes.clear();
+            offsets.resize(1);
+        }
+
+    private:
+        // whether value points into the bytes, which may move while they grow
+        [[nodiscard]] bool overlaps(std::string_view value) const {
+            return !value.empty() && !bytes.empty() && std::less_equal<const char *>()(bytes.data(), value.data()) &&
+                   std::less<const char *>()(value.data(), bytes.data() + bytes.size());
+        }
+
+        // add delta to the offsets from the one of cell i
+        void shift(unsigned long long int i, long long int delta) {
+            for (; i < offsets.size(); ++i)
+                offsets[i] = offset_type((long long int) offsets[i] + delta);
+        }
+
+        std::vector<char> bytes;
+        std::vector<offset_type> offsets = {0};
+    };
+
+    // strings of a low cardinality column, kept as a dictionary of unique strings and one code per cell
+    class category_buffer {
+    public:
+        typedef std::string value_type;
+        typedef unsigned int code_type;
+
+        category_buffer() = default;
+
+        category_buffer(const category_buffer &other) : dictionary(other.dictionary), codes(other.codes) {
+            index_dictionary();
+        }
+
+        category_buffer(category_buffer &&other) noexcept = default;
+
+        // build from a dictionary and the codes of the cells, which must be smaller than the size of the dictionary
+        category_buffer(std::deque<std::string> &&_dictionary, std::vector<code_type> &&_codes) :
+                dictionary(std::move(_dictionary)), codes(std::move(_codes)) {
+            index_dictionary();
+            if (lookup.size() != dictionary.size())
+                throw (std::invalid_argument("the categories are not unique"));
+            for (auto code : codes) {
+                if (code >= dictionary.size())
+                    throw (std::invalid_argument("the code of a category is out of range"));
+            }
+        }
+
+        category_buffer &operator=(const category_buffer &other) {
+            if (this != &other) {
+                dictionary = other.dictionary;
+                codes = other.codes;
+                index_dictionary();
+            }
+            return *this;
+        }
+
+        category_buffer &operator=(category_buffer &&other) noexcept = default;
+
+        [[nodiscard]] unsigned long long int size() const {
+            return codes.size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return codes.empty();
+        }
+
+        [[nodiscard]] unsigned long long int capacity() const {
+            return codes.capacity();
+        }
+
+        const std::string &operator[](unsigned long long int i) const {
+            return dictionary[codes[i]];
+        }
+
+        [[nodiscard]] const std::deque<std::string> &categories() const {
+            return dictionary;
+        }
+
+        [[nodiscard]] const std::vector<code_type> &get_codes() const {
+            return codes;
+        }
+
+        // code of a string, which is added into the dictionary when it is new
+        code_type encode(std::string_view value) {
+            auto item = lookup.find(value);
+            if (item != lookup.end())
+                return item->second;
+            auto code = code_type(dictionary.size());
+            dictionary.emplace_back(value);
+            lookup.emplace(dictionary.back(), code);
+            return code;
+        }
+
+        // code of a string, or -1 when it is not in the dictionary
+        [[nodiscard]] long long int find(std::string_view value) const {
+            auto item = lookup.find(value);
+            return item == lookup.end() ? -1 : item->second;
+        }
+
+        void emplace_back(std::string_view value) {
+            codes.emplace_back(encode(value));
+        }
+
+        void set(unsigned long long int i, std::string_view value) {
+            codes[i] = encode(value);
+        }
+
+        void erase(unsigned long long int i) {
+            codes.erase(codes.begin() + i);
+        }
+
+        // keep the cells whose flag is true, the dictionary is left as it is
+        void filter(const std::vector<bool> &keep) {
+            unsigned long long int k = 0;
+            for (unsigned long long int i = 0; i < codes.size(); ++i) {
+                if (keep[i])
+                    codes[k++] = codes[i];
+            }
+            codes.resize(k);
+        }
+
+        // append the cells of another category buffer, whose codes are translated into this dictionary
+        void append(const category_buffer &other) {
+            std::vector<code_type> translate;
+            translate.reserve(other.dictionary.size());
+            for (const auto &item : other.dictionary)
+                translate.emplace_back(encode(item));
+            codes.reserve(codes.size() + other.codes.size());
+            for (auto code : other.codes)
+                codes.emplace_back(translate[code]);
+        }
+
+        void reserve(unsigned long long int n) {
+            codes.reserve(n);
+        }
+
+        // the dictionary is left alone, shrinking a deque may move the strings the lookup table refers to
+        void shrink_to_fit() {
+            codes.shrink_to_fit();
+        }
+
+        // drop the categories which no cell uses, the others keep their order
+        void compact() {
+            std::vector<bool> used(dictionary.size(), false);
+            for (auto code : codes)
+                used[code] = true;
+            if (std::find(used.begin(), used.end(), false) == used.end())
+                return;
+            std::vector<code_type> translate(dictionary.size(), 0);
+            std::deque<std::string> kept;
+            for (unsigned long long int i = 0; i < dictionary.size(); ++i) {
+                if (used[i]) {
+                    translate[i] = code_type(kept.size());
+                    kept.emplace_back(std::move(dictionary[i]));
+                }
+            }
+            for (auto &code : codes)
+                code = translate[code];
+            dictionary.swap(kept);
+            index_dictionary();
+        }
+
+        // the codes are the payload, the dictionary and its lookup table are counted as strings,
+        // the nodes of the lookup table are estimated from its size
+        [[nodiscard]] memory_footprint memory_usage() const {
+            memory_footprint result;
+            result.add(codes);
+            result.strings = dictionary.size() * sizeof(std::string) + lookup.bucket_count() * sizeof(void *) +
+                             lookup.size() * (sizeof(std::pair<const std::string_view, code_type>) + 2 * sizeof(void *));
+            for (const auto &item : dictionary)
+                result.strings += toolbox::heap_bytes(item);
+            return result;
+        }
+
+        void clear() {
+            codes.clear();
+            dictionary.clear();
+            lookup.clear();
+        }
+
+    private:
+        void index_dictionary() {
+            lookup.clear();
+            for (unsigned long long int i = 0; i < dictionary.size(); ++i)
+                lookup.emplace(dictionary[i], code_type(i));
+        }
+
+        // the strings of a deque do not move, so the lookup table can refer to them
+        std::deque<std::string> dictionary;
+        std::unordered_map<std::string_view, code_type> lookup;
+        std::vector<code_type> codes;
+    };
+
+    // one bit per cell of a column, set when the cell holds a value and clear when it is missing,
+    // the words are only allocated while some cell is missing
+    class validity_bitmap {
+    public:
+        typedef unsigned long long int word_type;
+        static constexpr unsigned long long int word_bits = 64;
+
+        validity_bitmap() = default;
+
+        explicit validity_bitmap(unsigned long long int n) : length(n) {}
+
+        // bits of n cells, e.g. read back from a snapshot
+        validity_bitmap(std::vector<word_type> &&_bits, unsigned long long int n) : bits(std::move(_bits)), length(n) {
+            if (bits.size() != (n + word_bits - 1) / word_bits)
+                throw (std::invalid_argument("the size of the bitmap does not match its length"));
+            if (n % word_bits != 0)
+                bits.back() &= (word_type(1) << (n % word_bits)) - 1;
+            for (auto word : bits)
+                nulls += word_bits - count_ones(word);
+            nulls -= bits.size() * word_bits - n;
+            if (nulls == 0)
+                bits.clear();
+        }
+
+        [[nodiscard]] unsigned long long int size() const {
+            return length;
+        }
+
+        [[nodiscard]] unsigned long long int null_count() const {
+            return nulls;
+        }
+
+        // true when no cell is missing, the bits need not be looked at
+        [[nodiscard]] bool all_valid() const {
+            return nulls == 0;
+        }
+
+        // one word for every 64 cells, empty when all cells are valid
+        [[nodiscard]] const std::vector<word_type> &words() const {
+            return bits;
+        }
+
+        [[nodiscard]] bool valid(unsigned long long int i) const {
+            return nulls == 0 || (bits[i / word_bits] >> (i % word_bits) & 1) != 0;
+        }
+
+        void set(unsigned long long int i, bool value) {
+            if (value == valid(i))
+                return;
+            materialize();
+            bits[i / word_bits] ^= word_type(1) << (i % word_bits);
+            value ? --nulls : ++nulls;
+            if (nulls == 0)
+                bits.clear();
+        }
+
+        void push_back(bool value) {
+            if (value && nulls == 0) {
+                ++length;
+                return;
+            }
+            materialize();
+            if (length % word_bits == 0)
+                bits.emplace_back(0);
+            if (value)
+                bits.back() |= word_type(1) << (length % word_bits);
+            else ++nulls;
+            ++length;
+        }
+
+        // append n cells of the same validity
+        void push_back(bool value, unsigned long long int n) {
+            if (value && nulls == 0) {
+                length += n;
+                return;
+            }
+            for (; n != 0; --n)
+                push_back(value);
+        }
+
+        void append(const validity_bitmap &other) {
+            if (other.nulls == 0) {
+                push_back(true, other.length);
+                return;
+            }
+            materialize();
+            if (length % word_bits == 0) {
+                bits.insert(bits.end(), other.bits.begin(), other.bits.end());
+                length += other.length;
+                nulls += other.nulls;
+                return;
+            }
+            for (unsigned long long int i = 0; i < other.length; ++i)
+                push_back(other.valid(i));
+        }
+
+        // insert n valid cells before position
+        void insert(unsigned long long int position, unsigned long long int n) {
+            if (nulls == 0) {
+                length += n;
+                return;
+            }
+            validity_bitmap result;
+            for (unsigned long long int i = 0; i < position; ++i)
+                result.push_back(valid(i));
+            result.push_back(true, n);
+            for (unsigned long long int i = position; i < length; ++i)
+                result.push_back(valid(i));
+            *this = std::move(result);
+        }
+
+        // remove the cell at position, the following bits move down by one
+        void erase(unsigned long long int position) {
+            if (!valid(position))
+                --nulls;
+            --length;
+            if (nulls == 0) {
+                bits.clear();
+                return;
+            }
+            unsigned long long int k = position / word_bits;
+            word_type low = (word_type(1) << (position % word_bits)) - 1;
+            bits[k] = (bits[k] & low) | (bits[k] >> 1 & ~low);
+            for (++k; k < bits.size(); ++k) {
+                bits[k - 1] |= (bits[k] & 1) << (word_bits - 1);
+                bits[k] >>= 1;
+            }
+            bits.resize((length + word_bits - 1) / word_bits);
+        }
+
+        // keep the cells whose flag is true
+        void filter(const std::vector<bool> &keep) {
+            if (nulls == 0) {
+                length = std::count(keep.begin(), keep.begin() + (long long int) length, true);
+                return;
+            }
+            validity_bitmap result;
+            for (unsigned long long int i = 0; i < length; ++i) {
+                if (keep[i])
+                    result.push_back(valid(i));
+            }
+            *this = std::move(result);
+        }
+
+        void reserve(unsigned long long int n) {
+            if (nulls != 0)
+                bits.reserve((n + word_bits - 1) / word_bits);
+        }
+
+        void shrink_to_fit() {
+            bits.shrink_to_fit();
+        }
+
+        [[nodiscard]] memory_footprint memory_usage() const {
+            memory_footprint result;
+            result.add(bits);
+            return result;
+        }
+
+        void clear() {
+            bits.clear();
+            length = 0;
+            nulls = 0;
+        }
+
+        // call function with the index of every valid cell in [0, n), a whole word of bits is checked at a time
+        template<typename Function>
+        void for_each_valid(unsigned long long int n, Function &&function) const {
+            if (nulls == 0) {
+                for (unsigned long long int i = 0; i < n; ++i)
+                    function(i);
+                return;
+            }
+            for (unsigned long long int k = 0; k * word_bits < n; ++k) {
+                word_type word = bits[k];
+                unsigned long long int base = k * word_bits;
+                if (n - base < word_bits)
+                    word &= (word_type(1) << (n - base)) - 1;
+                if (word == ~word_type(0)) {
+                    for (unsigned long long int i = base; i < base + word_bits; ++i)
+                        function(i);
+                    continue;
+                }
+                for (; word != 0; word &= word - 1)
+                    function(base + count_trailing_zeros(word));
+            }
+        }
+
+        // call function with begin and end of every run of valid cells in [0, n)
+        template<typename Function>
+        void for_each_run(unsigned long long int n, Function &&function) const {
+            for_each_run(0, n, std::forward<Function>(function));
+        }
+
+        // call function with begin and end of every run of valid cells in [first, n)
+        template<typename Function>
+        void for_each_run(unsigned long long int first, unsigned long long int n, Function &&function) const {
+            if (first >= n)
+                return;
+            if (nulls == 0) {
+                function(first, n);
+                return;
+            }
+            const unsigned long long int none = n;
+            unsigned long long int run = none;
+            for (unsigned long long int k = first / word_bits; k * word_bits < n; ++k) {
+                word_type word = bits[k];
+                unsigned long long int base = k * word_bits;
+                if (base < first)
+                    word &= ~((word_type(1) << (first - base)) - 1);
+                if (n - base < word_bits)
+                    word &= (word_type(1) << (n - base)) - 1;
+                if (word == ~word_type(0)) {
+                    if (run == none)
+                        run = base;
+                    continue;
+                }
+                unsigned long long int position = 0;
+                while (position < word_bits) {
+                    word_type rest = word >> position;
+                    if (rest & 1) {
+                        if (run == none)
+                            run = base + position;
+                        position += count_trailing_zeros(~rest);
+                    } else {
+                        if (run != none) {
+                            function(run, base + position);
+                            run = none;
+                        }
+                        if (rest == 0)
+                            break;
+                        position += count_trailing_zeros(rest);
+                    }
+                }
+            }
+            if (run != none)
+                function(run, n);
+        }
+
+    private:
+        static unsigned int count_ones(word_type word) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_popcountll(word);
+#else
+            unsigned int n = 0;
+            for (; word != 0; word &= word - 1)
+                ++n;
+            return n;
+#endif
+        }
+
+        static unsigned int count_trailing_zeros(word_type word) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(word);
+#else
+            unsigned int n = 0;
+            for (; (word & 1) == 0; word >>= 1)
+                ++n;
+            return n;
+#endif
+        }
+
+        // allocate the words, with every cell valid so far
+        void materialize() {
+            if (nulls != 0)
+                return;
+            bits.assign((length + word_bits - 1) / word_bits, ~word_type(0));
+            if (length % word_bits != 0)
+                bits.back() = (word_type(1) << (length % word_bits)) - 1;
+        }
+
+        std::vector<word_type> bits;
+        unsigned long long int length = 0;
+        unsigned long long int nulls = 0;
+    };
+
+    // a column of dataframe<T> keeps its cells as std::vector<T>
+    template<typename T>
+    struct column_storage {
+        typedef std::variant<std::vector<T>> type;
+        template<typename U>
+        using buffer = std::vector<U>;
+    };
+
+    // a column of dataframe<user_variant> keeps one contiguous buffer of the physical type of its cells,
+    // strings in a string_buffer, and falls back to std::vector<user_variant> only when the cells have different types
+    template<>
+    struct column_storage<user_variant> {
+        typedef std::variant<std::vector<user_variant>, column_buffer<char>, column_buffer<int>,
+                column_buffer<long int>, column_buffer<float>, column_buffer<double>,
+                string_buffer, category_buffer> type;
+        template<typename U>
+        using buffer = std::conditional_t<std::is_same_v<U, std::string>, string_buffer, column_buffer<U>>;
+    };
+
+    template<typename T1, typename T2>
+    struct variant_contain : std::false_type {
+    };
+
+    template<typename T1, typename... Ts>
+    struct variant_contain<T1, std::variant<Ts...>> : std::disjunction<std::is_same<T1, Ts>...> {
+    };
+
+    template<typename T>
+    class csv_batch_reader;
+
+    template<typename T>
+    class query;
+
+    template<typename T = user_variant>
+    class dataframe {
+        friend class csv_batch_reader<T>;
+        friend class query<T>;
+        template<typename U>
+        friend class dataframe;
+    public:
+        class column_array {
+            typedef typename column_storage<T>::type storage_type;
+            template<typename U>
+            using buffer = typename column_storage<T>::template buffer<U>;
+            static constexpr bool typed_storage = std::variant_size_v<storage_type> != 1;
+            // type of the numbers written by transformed
+            typedef std::conditional_t<typed_storage, double, T> number_type;
+        public:
+            // row given to gathered for a missing cell
+            static constexpr unsigned long long int missing_row = ~0ULL;
+        private:
+            friend class dataframe;
+        public:
+            // proxy of one cell, reads and writes go through the column so that it can keep its layout
+            class cell_reference {
+                column_array *array = nullptr;
+                unsigned long long int i = 0;
+            public:
+                cell_reference() = default;
+
+                cell_reference(column_array *_array, unsigned long long int _i) : array(_array), i(_i) {}
+
+                cell_reference(const cell_reference &) = default;
+
+                operator T() const {
+                    return array->get(i);
+                }
+
+                cell_reference &operator=(const T &value) {
+                    array->set(i, value);
+                    return *this;
+                }
+
+                cell_reference &operator=(const cell_reference &other) {
+                    array->set(i, other.array->get(other.i));
+                    return *this;
+                }
+            };
+
+            typedef std::conditional_t<typed_storage, cell_reference, T &> reference;
+            typedef std::conditional_t<typed_storage, T, const T &> const_reference;
+            typedef std::conditional_t<typed_storage, cell_reference, T *> pointer;
+
+            template<typename Column, typename Reference>
+            class basic_iterator {
+                Column *array = nullptr;
+                unsigned long long int i = 0;
+            public:
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef T value_type;
+                typedef long long int difference_type;
+                typedef void pointer;
+                typedef Reference reference;
+
+                basic_iterator() = default;
+
+                basic_iterator(Column *_array, unsigned long long int _i) : array(_array), i(_i) {}
+
+                // iterator is convertible to const_iterator
+                template<typename C, typename R>
+                basic_iterator(const basic_iterator<C, R> &other) : array(other.column()), i(other.position()) {}
+
+                [[nodiscard]] Column *column() const {
+                    return array;
+                }
+
+                [[nodiscard]] unsigned long long int position() const {
+                    return i;
+                }
+
+                Reference operator*() const {
+                    return array->at(i);
+                }
+
+                Reference operator[](difference_type n) const {
+                    return array->at(i + n);
+                }
+
+                basic_iterator &operator++() {
+                    ++i;
+                    return *this;
+                }
+
+                basic_iterator operator++(int) {
+                    basic_iterator temp(*this);
+                    ++i;
+                    return temp;
+                }
+
+                basic_iterator &operator--() {
+                    --i;
+                    return *this;
+                }
+
+                basic_iterator operator--(int) {
+                    basic_iterator temp(*this);
+                    --i;
+                    return temp;
+                }
+
+                basic_iterator &operator+=(difference_type n) {
+                    i += n;
+                    return *this;
+                }
+
+                basic_iterator &operator-=(difference_type n) {
+                    i -= n;
+                    return *this;
+                }
+
+                friend basic_iterator operator+(basic_iterator iter, difference_type n) {
+                    return iter += n;
+                }
+
+                friend basic_iterator operator+(difference_type n, basic_iterator iter) {
+                    return iter += n;
+                }
+
+                friend basic_iterator operator-(basic_iterator iter, difference_type n) {
+                    return iter -= n;
+                }
+
+                friend difference_type operator-(const basic_iterator &a, const basic_iterator &b) {
+                    return difference_type(a.i) - difference_type(b.i);
+                }
+
+                friend bool operator==(const basic_iterator &a, const basic_iterator &b) {
+                    return a.i == b.i;
+                }
+
+                friend bool operator!=(const basic_iterator &a, const basic_iterator &b) {
+                    return a.i != b.i;
+                }
+
+                friend bool operator<(const basic_iterator &a, const basic_iterator &b) {
+                    return a.i < b.i;
+                }
+
+                friend bool operator>(const basic_iterator &a, const basic_iterator &b) {
+                    return a.i > b.i;
+                }
+
+                friend bool operator<=(const basic_iterator &a, const basic_iterator &b) {
+                    return a.i <= b.i;
+                }
+
+                friend bool operator>=(const basic_iterator &a, const basic_iterator &b) {
+                    return a.i >= b.i;
+                }
+            };
+
+        private:
+            typedef basic_iterator<const column_array, const_reference> const_iter;
+            typedef basic_iterator<column_array, reference> iter;
+            // shared by the copies of the column, the first one that writes to it takes a copy of its own
+            std::shared_ptr<storage_type> array;
+            validity_bitmap valid;
+            // counts the writes to single cells or to the whole column made outside of the frame, an index built at
+            // another count is stale
+            unsigned long long int writes = 0;
+
+            [[nodiscard]] const storage_type &values() const {
+                return *array;
+            }
+
+            // buffer of an empty column, which the columns that have been moved from share
+            static const std::shared_ptr<storage_type> &empty_values() {
+                static const std::shared_ptr<storage_type> empty = std::make_shared<storage_type>(pack({}));
+                return empty;
+            }
+
+            // every write goes through here, references into a shared buffer stay with the old owners
+            storage_type &values() {
+                if (array.use_count() > 1)
+                    array = std::make_shared<storage_type>(std::as_const(*array));
+                return *array;
+            }
+
+            static bool text_type(column_type type) {
+                return type == string_column || type == category_column;
+            }
+
+            // layout index of one value, 0 means that it is kept as T
+            static unsigned long long int kind_of(const T &item) {
+                if constexpr (typed_storage)
+                    return item.index() + 1;
+                else return cell_column;
+            }
+
+            template<typename V>
+            static constexpr bool is_category = std::is_same_v<std::decay_t<V>, category_buffer>;
+
+            template<typename V>
+            static constexpr bool is_strings = std::is_same_v<std::decay_t<V>, string_buffer>;
+
+            // whether the cells of the buffer are addressed by position only, and are read as strings
+            template<typename V>
+            static constexpr bool is_text = is_category<V> || is_strings<V>;
+
+            // whether item can be stored without changing the layout
+            [[nodiscard]] bool holds(const T &item) const {
+                if constexpr (typed_storage) {
+                    if (values().index() == category_column)
+                        return std::holds_alternative<std::string>(item);
+                }
+                return values().index() == kind_of(item);
+            }
+
+            template<typename U>
+            static decltype(auto) value_as(const T &item) {
+                if constexpr (std::is_same_v<U, T>)
+                    return (item);
+                else return std::get<U>(item);
+            }
+
+            // choose the layout of a whole column from its cells
+            static storage_type pack(std::vector<T> &&cells) {
+                if constexpr (typed_storage) {
+                    if (cells.empty())
+                        return storage_type(std::move(cells));
+                    auto kind = cells.front().index();
+                    for (const auto &item : cells) {
+                        if (item.index() != kind)
+                            return storage_type(std::move(cells));
+                    }
+                    return std::visit([&cells](const auto &first) {
+                        typedef std::decay_t<decltype(first)> U;
+                        std::vector<U> typed;
+                        typed.reserve(cells.size());
+                        for (auto &item : cells) {
+                            typed.emplace_back(std::move(std::get<U>(item)));
+                        }
+                        return storage_type(buffer<U>(std::move(typed)));
+                    }, cells.front());
+                } else return storage_type(std::move(cells));
+            }
+
+            // fall back to the layout of T cells
+            void to_cells() {
+                if (values().index() == cell_column)
+                    return;
+                std::vector<T> cells;
+                std::visit([&cells](auto &vec) {
+                    cells.reserve(vec.size());
+                    if constexpr (is_text<decltype(vec)>) {
+                        for (unsigned long long int i = 0; i < vec.size(); ++i)
+                            cells.emplace_back(std::string(vec[i]));
+                    } else {
+                        for (auto &item : vec) {
+                            cells.emplace_back(std::move(item));
+                        }
+                    }
+                }, values());
+                values() = std::move(cells);
+            }
+
+            static void mix(std::uint64_t &hash, std::uint64_t value) {
+                hash = (hash ^ value) * 0x9e3779b97f4a7c15ULL;
+                hash ^= hash >> 32;
+            }
+
+            // numbers hash by their value as a double, so 1 and 1L which are the same hash alike
+            template<typename V>
+            static std::uint64_t value_hash(const V &value) {
+                if constexpr (std::is_arithmetic_v<V>)
+                    return std::hash<double>()(double(value));
+                else return std::hash<V>()(value);
+            }
+
+            // whether x and y hold the same value, numbers of different types are the same when their values
+            // are equal as doubles and a word is only the same as a word
+            template<typename A, typename B>
+            static bool same_values(const A &x, const B &y) {
+                if constexpr (std::is_same_v<A, user_variant>) {
+                    return std::visit([&y](const auto &value) { return same_values(value, y); }, x);
+                } else if constexpr (std::is_same_v<B, user_variant>) {
+                    return std::visit([&x](const auto &value) { return same_values(x, value); }, y);
+                } else if constexpr (std::is_arithmetic_v<A> && std::is_arithmetic_v<B>) {
+                    if constexpr (std::is_same_v<A, B>)
+                        return x == y;
+                    else return double(x) == double(y);
+                } else if constexpr (std::is_same_v<A, B>) {
+                    return x == y;
+                } else if constexpr (std::is_convertible_v<const A &, std::string_view> &&
+                                     std::is_convertible_v<const B &, std::string_view>) {
+                    return std::string_view(x) == std::string_view(y);
+                } else return false;
+            }
+
+            template<typename A, typename B>
+            static int compare_values(const A &x, const B &y) {
+                if constexpr (std::is_same_v<A, user_variant>) {
+                    return std::visit([&y](const auto &value) { return compare_values(value, y); }, x);
+                } else if constexpr (std::is_same_v<B, user_variant>) {
+                    return std::visit([&x](const auto &value) { return compare_values(x, value); }, y);
+                } else if constexpr (std::is_arithmetic_v<A> && std::is_arithmetic_v<B>) {
+                    if constexpr (std::is_same_v<A, B>)
+                        return x < y ? -1 : (y < x ? 1 : 0);
+                    else return double(x) < double(y) ? -1 : (double(y) < double(x) ? 1 : 0);
+                } else if constexpr (std::is_arithmetic_v<A> || std::is_arithmetic_v<B>) {
+                    return std::is_arithmetic_v<A> ? -1 : 1;
+                } else return x < y ? -1 : (y < x ? 1 : 0);
+            }
+
+            // whether every cell is missing, which is also true for an empty column
+            [[nodiscard]] bool all_null() const {
+                return valid.null_count() == size();
+            }
+
+            // make the layout able to hold item, an empty column or a column of missing values
+            // adopts the layout of its first value
+            void fit(const T &item) {
+                if (holds(item))
+                    return;
+                if constexpr (typed_storage) {
+                    if (all_null()) {
+                        std::visit([this](const auto &value) {
+                            typedef std::decay_t<decltype(value)> U;
+                            values() = buffer<U>(std::vector<U>(size()));
+                        }, item);
+                        return;
+                    }
+                }
+                to_cells();
+            }
+
+            // call block with every run of valid values of a numeric buffer, or number with every valid number
+            // of T cells, words are skipped
+            template<typename Block, typename Number>
+            void scan_numbers(Block &&block, Number &&number) const {
+                std::visit([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (std::is_arithmetic_v<V>) {
+                        valid.for_each_run(vec.size(), [&](unsigned long long int begin, unsigned long long int end) {
+                            block(vec.data() + begin, end - begin);
+                        });
+                    } else if constexpr (std::is_same_v<V, user_variant>) {
+                        valid.for_each_valid(vec.size(), [&](unsigned long long int i) {
+                            std::visit([&number](const auto &value) {
+                                if constexpr (std::is_arithmetic_v<std::decay_t<decltype(value)>>)
+                                    number(double(value));
+                            }, vec[i]);
+                        });
+                    }
+                }, values());
+            }
+
+            // count, sum, min and max of the numbers which are not missing
+            [[nodiscard]] toolbox::reduction<double> reduce_numbers() const {
+                toolbox::reduction<double> result;
+                std::visit([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (std::is_arithmetic_v<V>) {
+                        toolbox::reduction<V> typed;
+                        valid.for_each_run(vec.size(), [&](unsigned long long int begin, unsigned long long int end) {
+                            toolbox::reduce(vec.data() + begin, end - begin, typed);
+                        });
+                        result.count = typed.count;
+                        result.sum = double(typed.sum);
+                        result.min = double(typed.min);
+                        result.max = double(typed.max);
+                    } else {
+                        scan_numbers([](const auto *, unsigned long long int) {}, [&result](double value) {
+                            ++result.count;
+                            result.sum += value;
+                            result.min = value < result.min ? value : result.min;
+                            result.max = value > result.max ? value : result.max;
+                        });
+                    }
+                }, values());
+                return result;
+            }
+
+            // sum of (x - mean)^2 over the numbers which are not missing
+            [[nodiscard]] double deviations(double mean) const {
+                double result = 0;
+                scan_numbers([&result, mean](const auto *data, unsigned long long int n) {
+                    result += toolbox::deviations(data, n, mean);
+                }, [&result, mean](double value) {
+                    result += (value - mean) * (value - mean);
+                });
+                return result;
+            }
+
+        public:
+            explicit column_array(int n = 0) : valid(n) {
+                array = std::make_shared<storage_type>(pack(std::vector<T>(n)));
+            }
+
+            // the copy shares the buffer until one of the two writes to it
+            column_array(const column_array &_array) : array(_array.array), valid(_array.valid),
+                                                       writes(_array.writes) {}
+
+            // the buffer is taken over, the other column is left empty
+            column_array(column_array &&_array) noexcept :
+                    array(std::exchange(_array.array, empty_values())), valid(std::move(_array.valid)),
+                    writes(_array.writes) {
+                _array.valid.clear();
+            }
+
+            explicit column_array(std::vector<T> &&_array) : valid(_array.size()) {
+                array = std::make_shared<storage_type>(pack(std::move(_array)));
+            }
+
+            explicit column_array(const std::vector<T> &_array) : valid(_array.size()) {
+                array = std::make_shared<storage_type>(pack(std::vector<T>(_array)));
+            }
+
+            template<typename InputIt>
+            void insert(const_iter position, InputIt start, InputIt end) {
+                if (position.position() == size()) {
+                    for (; start != end; ++start) {
+                        emplace_back(*start);
+                    }
+                } else {
+                    std::vector<T> cells(start, end);
+                    to_cells();
+                    auto &vec = std::get<0>(values());
+                    vec.insert(vec.begin() + position.position(), cells.begin(), cells.end());
+                    valid.insert(position.position(), cells.size());
+                }
+            }
+
+            // append all cells of another column, buffers of the same layout are copied in bulk
+            void append(const column_array &other) {
+                if (other.size() == 0)
+                    return;
+                if (&other == this) {
+                    // the cells are read from a copy, which shares the buffer, while this column grows
+                    append(column_array(other));
+                    return;
+                }
+                if (size() == 0) {
+                    array = other.array;
+                    valid = other.valid;
+                    return;
+                }
+                if (other.all_null()) {
+                    emplace_null(other.size());
+                    return;
+                }
+                if (all_null()) {
+                    // missing values take the layout of the other column
+                    auto n = size();
+                    std::visit([this, n](const auto &vec) {
+                        typedef typename std::decay_t<decltype(vec)>::value_type U;
+                        std::decay_t<decltype(vec)> filled;
+                        filled.reserve(n);
+                        for (unsigned long long int i = 0; i < n; ++i)
+                            filled.emplace_back(U());
+                        values() = std::move(filled);
+                    }, other.values());
+                }
+                valid.append(other.valid);
+                if (values().index() == other.values().index()) {
+                    std::visit([&other](auto &vec) {
+                        const auto &source = std::get<std::decay_t<decltype(vec)>>(other.values());
+                        if constexpr (is_text<decltype(vec)>)
+                            vec.append(source);
+                        else vec.insert(vec.end(), source.begin(), source.end());
+                    }, values());
+                } else if (text_type(type()) && text_type(other.type())) {
+                    // strings and categories are appended to each other without falling back to T cells
+                    std::visit([&other](auto &vec) {
+                        if constexpr (std::is_same_v<typename std::decay_t<decltype(vec)>::value_type, std::string>) {
+                            vec.reserve(vec.size() + other.size());
+                            for (unsigned long long int i = 0; i < other.size(); ++i)
+                                vec.emplace_back(std::get<std::string>(other.get(i)));
+                        }
+                    }, values());
+                } else {
+                    to_cells();
+                    auto &vec = std::get<0>(values());
+                    vec.reserve(vec.size() + other.size());
+                    for (unsigned long long int i = 0; i < other.size(); ++i) {
+                        vec.emplace_back(other.get(i));
+                    }
+                }
+            }
+
+            // append all cells of another column, the buffer is taken over when this column is empty
+            void append(column_array &&other) {
+                if (size() == 0 && other.size() != 0) {
+                    std::swap(array, other.array);
+                    std::swap(valid, other.valid);
+                } else append(other);
+            }
+
+            void reserve(unsigned long long int n) {
+                if (array.use_count() > 1) {
+                    // a shared buffer is copied straight into the new capacity
+                    array = std::make_shared<storage_type>(std::visit([n](const auto &vec) {
+                        std::decay_t<decltype(vec)> copy;
+                        copy.reserve(n);
+                        if constexpr (is_text<decltype(vec)>)
+                            copy.append(vec);
+                        else copy.insert(copy.end(), vec.begin(), vec.end());
+                        return storage_type(std::move(copy));
+                    }, std::as_const(*array)));
+                } else std::visit([n](auto &vec) { vec.reserve(n); }, values());
+                valid.reserve(n);
+            }
+
+            // number of cells the buffer holds before it has to grow
+            [[nodiscard]] unsigned long long int capacity() const {
+                return std::visit([](const auto &vec) -> unsigned long long int { return vec.capacity(); }, values());
+            }
+
+            // bytes held by the column: the cells in use with their validity bitmap, the capacity beyond them
+            // and the bytes of strings. deep adds the characters of strings kept one by one as T cells, which are
+            // walked cell by cell. a buffer shared by copies of the column is counted by each of them
+            [[nodiscard]] memory_footprint memory_usage(bool deep = true) const {
+                memory_footprint result = valid.memory_usage();
+                std::visit([&result, deep](const auto &vec) {
+                    typedef std::decay_t<decltype(vec)> Vec;
+                    if constexpr (std::is_same_v<Vec, std::vector<typename Vec::value_type>>) {
+                        result.add(vec);
+                        if (deep) {
+                            for (const auto &item : vec)
+                                result.strings += toolbox::heap_bytes(item);
+                        }
+                    } else result += vec.memory_usage();
+                }, values());
+                return result;
+            }
+
+            // release the capacity beyond the cells, a buffer shared with a copy is left alone as it would be copied
+            void shrink_to_fit() {
+                if (array.use_count() == 1)
+                    std::visit([](auto &vec) { vec.shrink_to_fit(); }, values());
+                valid.shrink_to_fit();
+            }
+
+            // shrink_to_fit after dropping the categories no cell uses, trimming strings kept as T cells and
+            // turning T cells which have come to hold one type into the buffer of that type
+            void compact() {
+                if (array.use_count() == 1) {
+                    if constexpr (typed_storage) {
+                        if (values().index() == cell_column)
+                            values() = pack(std::move(std::get<0>(values())));
+                    }
+                    std::visit([](auto &vec) {
+                        typedef std::decay_t<decltype(vec)> Vec;
+                        if constexpr (is_category<Vec>) {
+                            vec.compact();
+                        } else if constexpr (std::is_same_v<Vec, std::vector<typename Vec::value_type>>) {
+                            for (auto &item : vec) {
+                                if constexpr (std::is_same_v<typename Vec::value_type, std::string>)
+                                    item.shrink_to_fit();
+                                else if constexpr (typed_storage) {
+                                    if (auto *text = std::get_if<std::string>(&item))
+                                        text->shrink_to_fit();
+                                }
+                            }
+                        }
+                    }, values());
+                }
+                shrink_to_fit();
+            }
+
+            // remove all cells, the layout and the capacity are kept
+            void clear() {
+                std::visit([](auto &vec) { vec.clear(); }, values());
+                valid.clear();
+            }
+
+            [[nodiscard]] unsigned long long int size() const {
+                if (array == nullptr)
+                    return 0;
+                return std::visit([](const auto &vec) -> unsigned long long int { return vec.size(); }, values());
+            }
+
+            // physical layout of the column
+            [[nodiscard]] column_type type() const {
+                return column_type(values().index());
+            }
+
+            // contiguous buffer of the column if its physical type is U, nullptr otherwise
+            template<typename U>
+            [[nodiscard]] const buffer<U> *data_if() const {
+                if constexpr (variant_contain<buffer<U>, storage_type>::value)
+                    return std::get_if<buffer<U>>(&values());
+                else return nullptr;
+            }
+
+            // the buffer may be written to, so it counts as a write
+            template<typename U>
+            [[nodiscard]] buffer<U> *data_if() {
+                ++writes;
+                if constexpr (variant_contain<buffer<U>, storage_type>::value)
+                    return std::get_if<buffer<U>>(&values());
+                else return nullptr;
+            }
+
+            [[nodiscard]] const_iter begin() const {
+                return const_iter(this, 0);
+            }
+
+            [[nodiscard]] const_iter end() const {
+                return const_iter(this, size());
+            }
+
+            [[nodiscard]] iter begin() {
+                return iter(this, 0);
+            }
+
+            [[nodiscard]] iter end() {
+                return iter(this, size());
+            }
+
+            void erase(const_iter i) {
+                std::visit([&i](auto &vec) {
+                    if constexpr (is_text<decltype(vec)>)
+                        vec.erase(i.position());
+                    else vec.erase(vec.begin() + i.position());
+                }, values());
+                valid.erase(i.position());
+            }
+
+            // keep the cells whose flag is true in a single pass, keep must have one flag per cell
+            void filter(const std::vector<bool> &keep) {
+                std::visit([&keep](auto &vec) {
+                    if constexpr (is_text<decltype(vec)>) {
+                        vec.filter(keep);
+                    } else {
+                        auto first = vec.begin(), out = vec.begin();
+                        for (unsigned long long int i = 0; i < keep.size(); ++i, ++first) {
+                            if (keep[i]) {
+                                if (out != first)
+                                    *out = std::move(*first);
+                                ++out;
+                            }
+                        }
+                        vec.erase(out, vec.end());
+                    }
+                }, values());
+                valid.filter(keep);
+            }
+
+            // one flag per cell, predicate(value) with the value in the physical type of the column (a std::string_view
+            // for strings when predicate takes one), or as T when predicate cannot take it, false for missing cells
+            // and values predicate can take neither way
+            template<typename Predicate>
+            [[nodiscard]] std::vector<bool> mask(Predicate &&predicate) const {
+                std::vector<bool> result(size(), false);
+                std::visit([this, &result, &predicate](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    typedef decltype(vec[0]) E;
+                    if constexpr (std::is_invocable_v<Predicate &, E>) {
+                        valid.for_each_valid(vec.size(), [&](unsigned long long int i) {
+                            result[i] = bool(predicate(vec[i]));
+                        });
+                    } else if constexpr (std::is_invocable_v<Predicate &, const V &>) {
+                        valid.for_each_valid(vec.size(), [&](unsigned long long int i) {
+                            result[i] = bool(predicate(V(vec[i])));
+                        });
+                    } else if constexpr (std::is_invocable_v<Predicate &, const T &>) {
+                        valid.for_each_valid(vec.size(), [&](unsigned long long int i) {
+                            if constexpr (is_strings<decltype(vec)>)
+                                result[i] = bool(predicate(T(std::string(vec[i]))));
+                            else result[i] = bool(predicate(T(vec[i])));
+                        });
+                    }
+                }, values());
+                return result;
+            }
+
+            void emplace_back(const T &item) {
+                fit(item);
+                std::visit([&item](auto &vec) {
+                    vec.emplace_back(value_as<typename std::decay_t<decltype(vec)>::value_type>(item));
+                }, values());
+                valid.push_back(true);
+            }
+
+            // the value is moved into the buffer, strings are not copied
+            void emplace_back(T &&item) {
+                fit(item);
+                std::visit([&item](auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type U;
+                    if constexpr (std::is_same_v<U, T>)
+                        vec.emplace_back(std::move(item));
+                    else vec.emplace_back(std::get<U>(std::move(item)));
+                }, values());
+                valid.push_back(true);
+            }
+
+            // append n missing values, their cells keep the default value of the layout
+            void emplace_null(unsigned long long int n = 1) {
+                std::visit([n](auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type U;
+                    for (unsigned long long int i = 0; i < n; ++i)
+                        vec.emplace_back(U());
+                }, values());
+                valid.push_back(false, n);
+            }
+
+            // mark one cell as missing, its value is kept but skipped by scans
+            void set_null(unsigned long long int i) {
+                ++writes;
+                valid.set(i, false);
+            }
+
+            // number of writes to cells made outside of the frame, see writes
+            [[nodiscard]] unsigned long long int version() const {
+                return writes;
+            }
+
+            [[nodiscard]] bool is_null(unsigned long long int i) const {
+                return !valid.valid(i);
+            }
+
+            [[nodiscard]] unsigned long long int null_count() const {
+                return valid.null_count();
+            }
+
+            [[nodiscard]] const validity_bitmap &validity() const {
+                return valid;
+            }
+
+            // call function with every value which is not missing, in the physical type of the column
+            template<typename Function>
+            void for_each_value(Function &&function) const {
+                std::visit([this, &function](const auto &vec) {
+                    valid.for_each_valid(vec.size(), [&vec, &function](unsigned long long int i) {
+                        function(vec[i]);
+                    });
+                }, values());
+            }
+
+            // aggregations over the numbers which are not missing, words of mixed columns are skipped,
+            // a column without numbers gives NaN for mean, min, max and var
+            [[nodiscard]] unsigned long long int count() const {
+                // every valid cell of a numeric buffer is a number, other buffers are scanned
+                bool numbers = std::visit([](const auto &vec) {
+                    return std::is_arithmetic_v<typename std::decay_t<decltype(vec)>::value_type>;
+                }, values());
+                return numbers ? size() - null_count() : reduce_numbers().count;
+            }
+
+            [[nodiscard]] double sum() const {
+                return reduce_numbers().sum;
+            }
+
+            [[nodiscard]] double mean() const {
+                auto result = reduce_numbers();
+                return result.count == 0 ? std::numeric_limits<double>::quiet_NaN() : result.sum / result.count;
+            }
+
+            [[nodiscard]] double min() const {
+                auto result = reduce_numbers();
+                return result.count == 0 ? std::numeric_limits<double>::quiet_NaN() : result.min;
+            }
+
+            [[nodiscard]] double max() const {
+                auto result = reduce_numbers();
+                return result.count == 0 ? std::numeric_limits<double>::quiet_NaN() : result.max;
+            }
+
+            // sample variance, divided by count - 1
+            [[nodiscard]] double var() const {
+                auto result = reduce_numbers();
+                if (result.count < 2)
+                    return std::numeric_limits<double>::quiet_NaN();
+                return deviations(result.sum / result.count) / double(result.count - 1);
+            }
+
+            // moments of the values in rows [begin, end) which are not missing, read in a single pass:
+            // each block of a numeric buffer is reduced, then its deviations are summed while it is still in cache
+            [[nodiscard]] toolbox::moments statistics(unsigned long long int begin, unsigned long long int end) const {
+                const unsigned long long int block = 4096;
+                toolbox::moments result;
+                std::visit([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    valid.for_each_run(begin, std::min<unsigned long long int>(end, vec.size()),
+                                       [&](unsigned long long int first, unsigned long long int last) {
+                        result.cells += last - first;
+                        if constexpr (std::is_arithmetic_v<V>) {
+                            for (; first < last; first += block) {
+                                unsigned long long int n = std::min(block, last - first);
+                                toolbox::reduction<V> part;
+                                toolbox::reduce(vec.data() + first, n, part);
+                                toolbox::moments stats;
+                                stats.count = n;
+                                stats.mean = double(part.sum) / double(n);
+                                stats.m2 = toolbox::deviations(vec.data() + first, n, stats.mean);
+                                stats.min = double(part.min);
+                                stats.max = double(part.max);
+                                result.merge(stats);
+                            }
+                        } else if constexpr (std::is_same_v<V, user_variant>) {
+                            for (; first < last; ++first) {
+                                std::visit([&result](const auto &value) {
+                                    if constexpr (std::is_arithmetic_v<std::decay_t<decltype(value)>>)
+                                        result.push(double(value));
+                                }, vec[first]);
+                            }
+                        }
+                    });
+                }, values());
+                return result;
+            }
+
+            // hash of one value as hash_cells gives it for a column of that value alone
+            [[nodiscard]] static std::uint64_t hash_of(const T &item) {
+                std::uint64_t hash = 0;
+                if constexpr (typed_storage) {
+                    std::visit([&hash](const auto &value) { mix(hash, value_hash(value)); }, item);
+                } else mix(hash, value_hash(item));
+                return hash;
+            }
+
+            // whether row i holds item, numbers are compared by their value like range, so 5 is held by a long
+            // column holding 5, a word or a value of a dataframe<T> is only equal to itself
+            [[nodiscard]] bool holds_value(unsigned long long int i, const T &item) const {
+                if (!valid.valid(i))
+                    return false;
+                return std::visit([i, &item](const auto &vec) { return same_values(vec[i], item); }, values());
+            }
+
+            // order of row i and item, below zero when the cell comes first. numbers are compared as numbers
+            // and come before words, the order of sort_rows
+            [[nodiscard]] int compare_value(unsigned long long int i, const T &item) const {
+                return std::visit([i, &item](const auto &vec) { return compare_values(vec[i], item); }, values());
+            }
+
+            // order of rows a and b like compare_value
+            [[nodiscard]] int compare_cells(unsigned long long int a, unsigned long long int b) const {
+                return std::visit([a, b](const auto &vec) { return compare_values(vec[a], vec[b]); }, values());
+            }
+
+            // mix the hash of the cells of rows [begin, end) into hashes[i - begin], missing cells hash alike.
+            // the hash of a value does not depend on the layout, so equal cells of two columns hash alike
+            void hash_cells(unsigned long long int begin, unsigned long long int end, std::uint64_t *hashes) const {
+                std::visit([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (is_category<decltype(vec)>) {
+                        std::vector<std::uint64_t> categories;
+                        for (const auto &item : vec.categories())
+                            categories.emplace_back(value_hash(item));
+                        for (unsigned long long int i = begin; i < end; ++i)
+                            mix(hashes[i - begin], valid.valid(i) ? categories[vec.get_codes()[i]] : 0);
+                    } else if constexpr (typed_storage && std::is_same_v<V, T>) {
+                        for (unsigned long long int i = begin; i < end; ++i) {
+                            if (!valid.valid(i)) {
+                                mix(hashes[i - begin], 0);
+                                continue;
+                            }
+                            std::visit([&](const auto &value) {
+                                mix(hashes[i - begin], value_hash(value));
+                            }, vec[i]);
+                        }
+                    } else {
+                        for (unsigned long long int i = begin; i < end; ++i)
+                            mix(hashes[i - begin], valid.valid(i) ? value_hash(vec[i]) : 0);
+                    }
+                }, values());
+            }
+
+            // whether row i of this column and row j of other hold the same value, two missing cells are the same
+            [[nodiscard]] bool same_cell(unsigned long long int i, const column_array &other,
+                                         unsigned long long int j) const {
+                if (valid.valid(i) != other.valid.valid(j))
+                    return false;
+                if (!valid.valid(i))
+                    return true;
+                return std::visit([&](const auto &vec) {
+                    if (const auto *same = std::get_if<std::decay_t<decltype(vec)>>(&other.values()))
+                        return same_values(vec[i], (*same)[j]);
+                    return same_values(get(i), other.get(j));
+                }, values());
+            }
+
+            // whether rows a and b hold the same value, two missing cells are the same
+            [[nodiscard]] bool same_cells(unsigned long long int a, unsigned long long int b) const {
+                if (valid.valid(a) != valid.valid(b))
+                    return false;
+                if (!valid.valid(a))
+                    return true;
+                return std::visit([a, b](const auto &vec) {
+                    if constexpr (is_category<decltype(vec)>)
+                        return vec.get_codes()[a] == vec.get_codes()[b];
+                    else return same_values(vec[a], vec[b]);
+                }, values());
+            }
+
+            // add the values of rows [begin, end) which are not missing into statistics[groups[i - begin]],
+            // and their numbers into sums[groups[i - begin]]
+            void accumulate(unsigned long long int begin, unsigned long long int end,
+                            const unsigned long long int *groups, toolbox::moments *statistics, double *sums) const {
+                std::visit([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    valid.for_each_run(begin, std::min<unsigned long long int>(end, vec.size()),
+                                       [&](unsigned long long int first, unsigned long long int last) {
+                        for (unsigned long long int i = first; i < last; ++i) {
+                            auto group = groups[i - begin];
+                            ++statistics[group].cells;
+                            if constexpr (std::is_arithmetic_v<V>) {
+                                statistics[group].push(double(vec[i]));
+                                sums[group] += double(vec[i]);
+                            } else if constexpr (std::is_same_v<V, user_variant>) {
+                                std::visit([&](const auto &value) {
+                                    if constexpr (std::is_arithmetic_v<std::decay_t<decltype(value)>>) {
+                                        statistics[group].push(double(value));
+                                        sums[group] += double(value);
+                                    }
+                                }, vec[i]);
+                            }
+                        }
+                    });
+                }, values());
+            }
+
+            // stable sort of rows by the cells of this column, missing cells go last in both orders.
+            // numbers and categories are radix sorted, strings and mixed cells are merge sorted by up to threads
+            // threads (0 means all cores), where numbers come before words
+            void sort_rows(std::vector<unsigned long long int> &rows, bool ascending, unsigned int threads) const {
+                std::vector<unsigned long long int> missing, present;
+                for (auto row : rows)
+                    (valid.valid(row) ? present : missing).emplace_back(row);
+                std::visit([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (std::is_arithmetic_v<V> || is_category<decltype(vec)>) {
+                        std::vector<std::uint64_t> keys;
+                        keys.reserve(present.size());
+                        if constexpr (is_category<decltype(vec)>) {
+                            // the rank of every category in the sorted dictionary
+                            const auto &categories = vec.categories();
+                            std::vector<unsigned long long int> order(categories.size());
+                            std::iota(order.begin(), order.end(), 0);
+                            std::sort(order.begin(), order.end(), [&categories](auto a, auto b) {
+                                return categories[a] < categories[b];
+                            });
+                            std::vector<std::uint64_t> ranks(categories.size());
+                            for (unsigned long long int k = 0; k < order.size(); ++k)
+                                ranks[order[k]] = k;
+                            for (auto row : present)
+                                keys.emplace_back(ranks[vec.get_codes()[row]]);
+                        } else {
+                            for (auto row : present)
+                                keys.emplace_back(toolbox::order_key(vec[row]));
+                        }
+                        if (!ascending) {
+                            for (auto &key : keys)
+                                key = ~key;
+                        }
+                        toolbox::radix_sort(keys, present);
+                    } else {
+                        auto less = [&vec](unsigned long long int a, unsigned long long int b) {
+                            if constexpr (typed_storage && std::is_same_v<V, T>) {
+                                return std::visit([](const auto &x, const auto &y) {
+                                    typedef std::decay_t<decltype(x)> X;
+                                    typedef std::decay_t<decltype(y)> Y;
+                                    if constexpr (std::is_arithmetic_v<X> && std::is_arithmetic_v<Y>)
+                                        return double(x) < double(y);
+                                    else if constexpr (std::is_arithmetic_v<X> || std::is_arithmetic_v<Y>)
+                                        return std::is_arithmetic_v<X>;
+                                    else return x < y;
+                                }, vec[a], vec[b]);
+                            } else return vec[a] < vec[b];
+                        };
+                        if (ascending)
+                            toolbox::parallel_stable_sort(present, less, threads);
+                        else toolbox::parallel_stable_sort(present, [&less](auto a, auto b) { return less(b, a); },
+                                                           threads);
+                    }
+                }, values());
+                present.insert(present.end(), missing.begin(), missing.end());
+                rows.swap(present);
+            }
+
+            // put the cells at rows in place of the column, rows holds every row once so the cells are moved
+            void gather(const std::vector<unsigned long long int> &rows) {
+                // a shared buffer is not copied only to be overwritten, strings are copied into a new block
+                if (text_type(type()) || array.use_count() > 1) {
+                    column_array result = gathered(rows);
+                    std::swap(array, result.array);
+                    std::swap(valid, result.valid);
+                    return;
+                }
+                validity_bitmap result;
+                if (!valid.all_valid()) {
+                    for (auto row : rows)
+                        result.push_back(valid.valid(row));
+                } else result.push_back(true, rows.size());
+                std::visit([&rows](auto &vec) {
+                    typedef std::decay_t<decltype(vec)> Vec;
+                    if constexpr (!is_text<Vec>) {
+                        typedef typename Vec::value_type V;
+                        std::vector<V> values;
+                        values.reserve(rows.size());
+                        auto *data = vec.data();
+                        for (auto row : rows)
+                            values.emplace_back(std::move(data[row]));
+                        vec = Vec(std::move(values));
+                    }
+                }, values());
+                valid = std::move(result);
+            }
+
+            // a new column of the same layout holding the cells at rows, a row equal to missing_row gives a missing cell
+            [[nodiscard]] column_array gathered(const std::vector<unsigned long long int> &rows) const {
+                column_array result;
+                for (auto row : rows)
+                    result.valid.push_back(row != missing_row && valid.valid(row));
+                result.values() = std::visit([&rows](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (is_category<decltype(vec)>) {
+                        std::deque<std::string> dictionary(vec.categories());
+                        if (dictionary.empty())
+                            dictionary.emplace_back();
+                        std::vector<category_buffer::code_type> codes;
+                        codes.reserve(rows.size());
+                        for (auto row : rows)
+                            codes.emplace_back(row == missing_row ? 0 : vec.get_codes()[row]);
+                        return storage_type(category_buffer(std::move(dictionary), std::move(codes)));
+                    } else if constexpr (is_strings<decltype(vec)>) {
+                        string_buffer strings;
+                        strings.reserve(rows.size());
+                        for (auto row : rows)
+                            strings.emplace_back(row == missing_row ? std::string_view() : vec[row]);
+                        return storage_type(std::move(strings));
+                    } else {
+                        std::vector<V> values;
+                        values.reserve(rows.size());
+                        for (auto row : rows)
+                            values.emplace_back(row == missing_row ? V() : vec[row]);
+                        return storage_type(std::decay_t<decltype(vec)>(std::move(values)));
+                    }
+                }, values());
+                return result;
+            }
+
+            // a column holding the cells in rows [begin, end), which shares the buffer when it covers every row
+            [[nodiscard]] column_array sliced(unsigned long long int begin, unsigned long long int end) const {
+                if (begin == 0 && end == size())
+                    return *this;
+                column_array result;
+                if (valid.all_valid()) {
+                    result.valid.push_back(true, end - begin);
+                } else {
+                    for (unsigned long long int i = begin; i < end; ++i)
+                        result.valid.push_back(valid.valid(i));
+                }
+                result.values() = std::visit([begin, end](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (is_category<decltype(vec)>) {
+                        std::deque<std::string> dictionary(vec.categories());
+                        if (dictionary.empty())
+                            dictionary.emplace_back();
+                        std::vector<category_buffer::code_type> codes(vec.get_codes().begin() + begin,
+                                                                      vec.get_codes().begin() + end);
+                        return storage_type(category_buffer(std::move(dictionary), std::move(codes)));
+                    } else if constexpr (is_strings<decltype(vec)>) {
+                        return storage_type(vec.slice(begin, end));
+                    } else {
+                        std::vector<V> values(vec.data() + begin, vec.data() + end);
+                        return storage_type(std::decay_t<decltype(vec)>(std::move(values)));
+                    }
+                }, values());
+                return result;
+            }
+
+            // a new column where every number which is not missing is replaced by function(number) and every word
+            // by 0, numbers of dataframe<user_variant> become doubles, the buffer is written once without a copy
+            // of this column, missing cells stay missing
+            template<typename Function>
+            [[nodiscard]] column_array transformed(Function &&function) const {
+                column_array result;
+                result.valid = valid;
+                if constexpr (!std::is_arithmetic_v<number_type>) {
+                    result.array = array;
+                } else {
+                    result.values() = std::visit([&](const auto &vec) {
+                        typedef typename std::decay_t<decltype(vec)>::value_type V;
+                        std::vector<number_type> numbers(vec.size());
+                        if constexpr (std::is_arithmetic_v<V>) {
+                            valid.for_each_run(vec.size(), [&](unsigned long long int begin,
+                                                               unsigned long long int end) {
+                                const V *source = vec.data();
+                                number_type *target = numbers.data();
+                                for (unsigned long long int i = begin; i < end; ++i)
+                                    target[i] = number_type(function(double(source[i])));
+                            });
+                        } else if constexpr (std::is_same_v<V, user_variant>) {
+                            valid.for_each_valid(vec.size(), [&](unsigned long long int i) {
+                                std::visit([&](const auto &value) {
+                                    if constexpr (std::is_arithmetic_v<std::decay_t<decltype(value)>>)
+                                        numbers[i] = number_type(function(double(value)));
+                                }, vec[i]);
+                            });
+                        }
+                        return storage_type(buffer<number_type>(std::move(numbers)));
+                    }, values());
+                }
+                return result;
+            }
+
+            // replace every number which is not missing by function(number) like transformed, a buffer which
+            // already has the result type is updated in place
+            template<typename Function>
+            void transform_numbers(Function &&function) {
+                if constexpr (std::is_arithmetic_v<number_type>) {
+                    ++writes;
+                    if (auto *vec = array.use_count() == 1 ? data_if<number_type>() : nullptr) {
+                        number_type *data = vec->data();
+                        valid.for_each_run(vec->size(), [&](unsigned long long int begin, unsigned long long int end) {
+                            for (unsigned long long int i = begin; i < end; ++i)
+                                data[i] = number_type(function(double(data[i])));
+                        });
+                        return;
+                    }
+                    column_array result = transformed(std::forward<Function>(function));
+                    std::swap(array, result.array);
+                }
+            }
+
+            // append one value of physical type U, it is stored directly when the layout is already U
+            template<typename U>
+            void emplace_back_typed(U &&item) {
+                typedef std::decay_t<U> value_type;
+                if constexpr (typed_storage && std::is_convertible_v<const value_type &, std::string_view>) {
+                    // words are copied straight into the bytes of the column, no std::string is made for them
+                    if (auto *vec = std::get_if<string_buffer>(&values())) {
+                        vec->emplace_back(item);
+                        valid.push_back(true);
+                        return;
+                    }
+                    if (auto *vec = std::get_if<category_buffer>(&values())) {
+                        vec->emplace_back(item);
+                        valid.push_back(true);
+                        return;
+                    }
+                }
+                if constexpr (std::is_same_v<value_type, std::string_view>) {
+                    emplace_back_typed(std::string(item));
+                } else {
+                    if constexpr (variant_contain<buffer<value_type>, storage_type>::value) {
+                        if (auto *vec = std::get_if<buffer<value_type>>(&values())) {
+                            vec->emplace_back(std::forward<U>(item));
+                            valid.push_back(true);
+                            return;
+                        }
+                    }
+                    emplace_back(T(std::forward<U>(item)));
+                }
+            }
+
+            // call function with the buffer of the column, which is a std::vector of its physical type
+            template<typename Function>
+            decltype(auto) visit_buffer(Function &&function) const {
+                return std::visit(std::forward<Function>(function), values());
+            }
+
+            // read one cell without bounds check
+            [[nodiscard]] T get(unsigned long long int i) const {
+                return std::visit([i](const auto &vec) {
+                    if constexpr (is_strings<decltype(vec)>)
+                        return T(std::string(vec[i]));
+                    else return T(vec[i]);
+                }, values());
+            }
+
+            // write one cell without bounds check, a value of another type turns the column into T cells
+            void set(unsigned long long int i, const T &item) {
+                ++writes;
+                fit(item);
+                std::visit([i, &item](auto &vec) {
+                    if constexpr (is_text<decltype(vec)>)
+                        vec.set(i, std::get<std::string>(item));
+                    else vec[i] = value_as<typename std::decay_t<decltype(vec)>::value_type>(item);
+                }, values());
+                valid.set(i, true);
+            }
+
+            // turn a column of strings into a dictionary of unique strings and codes, false for other columns
+            bool categorize() {
+                if constexpr (typed_storage) {
+                    if (values().index() == category_column)
+                        return true;
+                    if (all_null()) {
+                        category_buffer categories;
+                        for (unsigned long long int i = 0; i < size(); ++i)
+                            categories.emplace_back(std::string_view());
+                        values() = std::move(categories);
+                        return true;
+                    }
+                    if (auto *vec = std::get_if<string_buffer>(&values())) {
+                        category_buffer categories;
+                        categories.reserve(vec->size());
+                        for (const auto &item : std::as_const(*vec))
+                            categories.emplace_back(item);
+                        values() = std::move(categories);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // dictionary and codes of a categorical column, nullptr for other columns
+            [[nodiscard]] const category_buffer *category_if() const {
+                if constexpr (typed_storage)
+                    return std::get_if<category_buffer>(&values());
+                else return nullptr;
+            }
+
+            [[nodiscard]] const_reference at(unsigned long long int i) const {
+                if constexpr (typed_storage)
+                    return get(i);
+                else return std::get<0>(values())[i];
+            }
+
+            // a reference to a T cell may be written to, a cell_reference writes through set
+            [[nodiscard]] reference at(unsigned long long int i) {
+                if constexpr (typed_storage)
+                    return cell_reference(this, i);
+                else {
+                    ++writes;
+                    return std::get<0>(values())[i];
+                }
+            }
+
+            [[nodiscard]] pointer address(unsigned long long int i) {
+                if constexpr (typed_storage)
+                    return cell_reference(this, i);
+                else {
+                    ++writes;
+                    return &std::get<0>(values())[i];
+                }
+            }
+
+            column_array &operator=(const column_array &other) {
+                if (this != &other) {
+                    if (other.size() == size()) {
+                        ++writes;
+                        array = other.array;
+                        valid = other.valid;
+                        return *this;
+                    } else throw (std::invalid_argument("The length of the two is not the same"));
+                }
+                return *this;
+            }
+
+            column_array &operator=(const std::vector<T> &_array) {
+                if (_array.size() == size()) {
+                    ++writes;
+                    values() = pack(std::vector<T>(_array));
+                    valid = validity_bitmap(size());
+                    return *this;
+                }
+                throw (std::invalid_argument("The length of the two is not the same"));
+            }
+
+            column_array &operator=(std::vector<T> &&_array) {
+                if (_array.size() == size()) {
+                    ++writes;
+                    values() = pack(std::move(_array));
+                    valid = validity_bitmap(size());
+                    return *this;
+                }
+                throw (std::invalid_argument("The length of the two is not the same"));
+            }
+
+            // copy of the cells, typed buffers are converted into T
+            [[maybe_unused]] [[nodiscard]] std::conditional_t<typed_storage, std::vector<T>, const std::vector<T> &>
+            get_std_vector() const {
+                if constexpr (typed_storage)
+                    return std::vector<T>(begin(), end());
+                else return std::get<0>(values());
+            }
+
+            // the column is turned into T cells, so that the vector can be modified directly
+            [[maybe_unused]] std::vector<T> &get_std_vector() {
+                ++writes;
+                to_cells();
+                return std::get<0>(values());
+            }
+
+            const_reference operator[](unsigned long long int i) const {
+                if (i < size())
+                    return at(i);
+                else {
+                    std::stringstream ssTemp;
+                    ssTemp << i;
+                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+                }
+            }
+
+            reference operator[](unsigned long long int i) {
+                if (i < size())
+                    return at(i);
+                else {
+                    std::stringstream ssTemp;
+                    ssTemp << i;
+                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+                }
+            }
+
+            friend std::ostream &operator<<(std::ostream &cout, column_array &arr) {
+                for (unsigned long long int i = 0; i < arr.size(); ++i) {
+                    cout << arr.get(i) << ' ';
+                }
+                return cout;
+            }
+        };
+
+        class row_array {
+            typedef typename column_array::pointer pointer;
+            typedef typename column_array::reference reference;
+            typedef typename column_array::const_reference const_reference;
+            typedef typename std::vector<pointer>::const_iterator const_iter;
+            typedef typename std::vector<pointer>::iterator iter;
+            std::vector<pointer> *array = nullptr;
+
+            static reference deref(const pointer &item) {
+                if constexpr (std::is_pointer_v<pointer>)
+                    return *item;
+                else return item;
+            }
+
+        public:
+            explicit row_array(int n = 0) {
+                array = new std::vector<pointer>(n);
+            }
+
+            row_array(const row_array &_array) {
+                array = new std::vector<pointer>(*_array.array);
+            }
+
+            row_array(row_array &&_array) noexcept {
+                array = new std::vector<pointer>(std::move(*_array.array));
+            }
+
+            [[maybe_unused]] explicit row_array(std::vector<pointer> &&_array) {
+                array = new std::vector<pointer>(_array);
+            }
+
+            [[maybe_unused]] explicit row_array(const std::vector<pointer> &_array) {
+                array = new std::vector<pointer>(_array);
+            }
+
+            ~row_array() {
+                delete array;
+            }
+
+            void insert(const_iter position, const_iter start, const_iter end) {
+                array->insert(position, start, end);
+            }
+
+            [[nodiscard]] unsigned long long int size() const {
+                if (array == nullptr)
+                    return 0;
+                return array->size();
+            }
+
+            [[nodiscard]] const_iter begin() const {
+                return array->begin();
+            }
+
+            [[nodiscard]] const_iter end() const {
+                return array->end();
+            }
+
+            [[nodiscard]] iter begin() {
+                return array->begin();
+            }
+
+            [[nodiscard]] iter end() {
+                return array->end();
+            }
+
+            row_array &operator=(const row_array &other) {
+                if (this != &other) {
+                    if (other.size() == array->size()) {
+                        for (int i = 0; i < other.size(); ++i) {
+                            deref((*array)[i]) = other[i];
+                        }
+                        return *this;
+                    } else throw (std::invalid_argument("The length of the two is not the same"));
+                }
+                return *this;
+            }
+
+            row_array &operator=(const std::vector<T> &_array) {
+                if (_array.size() == array->size()) {
+                    for (int i = 0; i < _array.size(); ++i) {
+                        deref((*array)[i]) = _array[i];
+                    }
+                    return *this;
+                }
+                throw (std::invalid_argument("The length of the two is not the same"));
+            }
+
+            row_array &operator=(std::vector<T> &&_array) {
+                if (_array.size() == array->size()) {
+                    for (int i = 0; i < _array.size(); ++i) {
+                        deref((*array)[i]) = _array[i];
+                    }
+                    return *this;
+                }
+                throw (std::invalid_argument("The length of the two is not the same"));
+            }
+
+            [[maybe_unused]] const std::vector<pointer> &get_point_vector() const {
+                return *array;
+            }
+
+            [[maybe_unused]] std::vector<pointer> &get_point_vector() {
+                return *array;
+            }
+
+            [[maybe_unused]] std::vector<T> get_std_vector() const {
+                std::vector<T> result;
+                if (array == nullptr)
+                    throw (std::invalid_argument("This row array is invalid!"));
+                for (const pointer &item : *array) {
+                    result.push_back(deref(item));
+                }
+                return result;
+            }
+
+            void push_back(pointer item) {
+                array->emplace_back(item);
+            }
+
+            const_reference operator[](unsigned long long int i) const {
+                if (i < array->size())
+                    return deref((*array)[i]);
+                else {
+                    std::stringstream ssTemp;
+                    ssTemp << i;
+                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+                }
+            }
+
+            reference operator[](unsigned long long int i) {
+                if (i < array->size())
+                    return deref((*array)[i]);
+                else {
+                    std::stringstream ssTemp;
+                    ssTemp << i;
+                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+                }
+            }
+
+            friend std::ostream &operator<<(std::ostream &cout, row_array &arr) {
+                for (const auto &item : *arr.array) {
+                    cout << T(deref(item)) << ' ';
+                }
+                return cout;
+            }
+        };
+
+        // view of one row, a frame pointer and a row index, nothing is allocated
+        template<typename Frame, typename Reference>
+        class basic_row_view {
+            Frame *frame = nullptr;
+            unsigned long long int row = 0;
+
+            template<typename F, typename R>
+            friend class basic_row_view;
+
+        public:
+            typedef typename column_array::template basic_iterator<const basic_row_view, Reference> iterator;
+
+            basic_row_view() = default;
+
+            basic_row_view(Frame *_frame, unsigned long long int _row) : frame(_frame), row(_row) {}
+
+            basic_row_view(const basic_row_view &) = default;
+
+            // row_view is convertible to const_row_view
+            template<typename F, typename R>
+            basic_row_view(const basic_row_view<F, R> &other) : frame(other.frame), row(other.row) {}
+
+            [[nodiscard]] unsigned long long int index() const {
+                return row;
+            }
+
+            [[nodiscard]] unsigned long long int size() const {
+                return frame->matrix.size();
+            }
+
+            // unchecked cell of the jth column
+            [[nodiscard]] Reference at(unsigned long long int j) const {
+                if constexpr (std::is_const_v<Frame>)
+                    return std::as_const(*frame->matrix[j]).at(row);
+                else return frame->matrix[j]->at(row);
+            }
+
+            Reference operator[](unsigned long long int j) const {
+                if (j < size())
+                    return at(j);
+                std::stringstream ssTemp;
+                ssTemp << j;
+                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            }
+
+            Reference operator[](const std::string &col) const {
+                return at(frame->position(col));
+            }
+
+            [[nodiscard]] iterator begin() const {
+                return iterator(this, 0);
+            }
+
+            [[nodiscard]] iterator end() const {
+                return iterator(this, size());
+            }
+
+            // assignments write the values into the frame, as row_array does
+            template<typename F, typename R>
+            const basic_row_view &operator=(const basic_row_view<F, R> &other) const {
+                if (other.size() != size())
+                    throw (std::invalid_argument("The length of the two is not the same"));
+                if (other.frame != frame || other.row != row) {
+                    for (unsigned long long int j = 0; j < size(); ++j)
+                        frame->matrix[j]->set(row, std::as_const(*other.frame->matrix[j]).get(other.row));
+                }
+                return *this;
+            }
+
+            const basic_row_view &operator=(const basic_row_view &other) const {
+                return this->operator=<Frame, Reference>(other);
+            }
+
+            const basic_row_view &operator=(const std::vector<T> &_array) const {
+                if (_array.size() != size())
+                    throw (std::invalid_argument("The length of the two is not the same"));
+                for (unsigned long long int j = 0; j < size(); ++j)
+                    frame->matrix[j]->set(row, _array[j]);
+                return *this;
+            }
+
+            [[maybe_unused]] [[nodiscard]] std::vector<T> get_std_vector() const {
+                std::vector<T> result;
+                result.reserve(size());
+                for (unsigned long long int j = 0; j < size(); ++j)
+                    result.emplace_back(std::as_const(*frame->matrix[j]).get(row));
+                return result;
+            }
+
+            // the former pointer based row, built only when asked for
+            operator row_array() const {
+                row_array result;
+                for (auto &item : frame->matrix)
+                    result.push_back(item->address(row));
+                return result;
+            }
+
+            friend std::ostream &operator<<(std::ostream &cout, const basic_row_view &view) {
+                for (unsigned long long int j = 0; j < view.size(); ++j)
+                    cout << T(view.at(j)) << ' ';
+                return cout;
+            }
+        };
+
+        typedef basic_row_view<dataframe, typename column_array::reference> row_view;
+        typedef basic_row_view<const dataframe, typename column_array::const_reference> const_row_view;
+
+        // range of the row views of a frame, used by rows()
+        template<typename Frame, typename View>
+        class row_range {
+            Frame *frame = nullptr;
+            unsigned long long int first = 0, last = 0;
+
+        public:
+            class iterator {
+                Frame *frame = nullptr;
+                unsigned long long int row = 0;
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef View value_type;
+                typedef long long int difference_type;
+                typedef void pointer;
+                typedef View reference;
+
+                iterator() = default;
+
+                iterator(Frame *_frame, unsigned long long int _row) : frame(_frame), row(_row) {}
+
+                View operator*() const {
+                    return View(frame, row);
+                }
+
+                iterator &operator++() {
+                    ++row;
+                    return *this;
+                }
+
+                iterator operator++(int) {
+                    iterator temp(*this);
+                    ++row;
+                    return temp;
+                }
+
+                friend bool operator==(const iterator &a, const iterator &b) {
+                    return a.row == b.row;
+                }
+
+                friend bool operator!=(const iterator &a, const iterator &b) {
+                    return a.row != b.row;
+                }
+            };
+
+            row_range(Frame *_frame, unsigned long long int _first, unsigned long long int _last)
+                    : frame(_frame), first(_first), last(_last) {}
+
+            [[nodiscard]] iterator begin() const {
+                return iterator(frame, first);
+            }
+
+            [[nodiscard]] iterator end() const {
+                return iterator(frame, last);
+            }
+
+            [[nodiscard]] unsigned long long int size() const {
+                return last - first;
+            }
+        };
+
+    private:
+        typedef std::vector<std::string> string_vector;
+        typedef typename std::vector<column_array *>::const_iterator dataframe_const_iter;
+        typedef typename std::vector<column_array *>::iterator dataframe_iter;
+        bool is_scaler = false;
+
+    public:
+        // constructed by file name
+        explicit dataframe(const std::string &filename, const char &delimiter = ',', unsigned int threads = 1,
+                           const csv_schema &schema = {}) :
+            dataframe_name(filename), width(0), length(0) {
+            read_csv(filename, delimiter, threads, schema);
+        }
+
+        // constructed by width and length
+        explicit dataframe(unsigned long long int _width = 0, std::string name = "dataframe") :
+            dataframe_name(std::move(name)), width(_width), length(0) {
+            string_vector temp;
+            for (unsigned long long int i = 0; i < _width; i++)
+                temp.emplace_back(std::to_string(i));
+            column_paste(temp);
+        }
+
+        // constructed by string vector
+        explicit dataframe(const string_vector &columns, std::string name = "dataframe") :
+            dataframe_name(std::move(name)), width(columns.size()), length(0) {
+            column_paste(columns);
+        }
+
+        // copy constructor
+        dataframe(const dataframe &dataframe) :
+                dataframe_name(dataframe.dataframe_name),
+                width(dataframe.width),
+                length(dataframe.length),
+                column(dataframe.column),
+                index(dataframe.index),
+                indexes(dataframe.shared_indexes()) {
+            matrix.clear();
+            for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
+                matrix.emplace_back(new column_array(**i));
+            }
+        }
+
+        // move constructor, the columns are taken over and the other dataframe is left empty
+        dataframe(dataframe &&dataframe) noexcept:
+                dataframe_name(std::move(dataframe.dataframe_name)),
+                column(std::move(dataframe.column)),
+                matrix(std::move(dataframe.matrix)),
+                width(dataframe.width),
+                length(dataframe.length),
+                index(std::move(dataframe.index)),
+                indexes(std::move(dataframe.indexes)) {
+            dataframe.clear();
+        }
+
+        ~dataframe() {
+            for (auto i = 0; i < matrix.size(); ++i) {
+                delete matrix[i];
+            }
+        }
+
+        dataframe_iter begin() {
+            return matrix.begin();
+        }
+
+        dataframe_const_iter begin() const {
+            return matrix.begin();
+        }
+
+        dataframe_iter end() {
+            return matrix.end();
+        }
+
+        dataframe_const_iter end() const {
+            return matrix.end();
+        }
+
+        // determine whether the column is included
+        bool contain(const std::string &col) {
+            return index.find(col) != index.end();
+        }
+
+        // insert one column
+        bool insert(const std::string &col) {
+            ++width;
+            column.emplace_back(col);
+            index.emplace(col, index.size());
+            matrix.emplace_back(new column_array(length));
+            return true;
+        }
+
+        // insert one column from std::vector<T>
+        bool insert(const std::string &col, column_array &&array) {
+            if (array.size() == row_num()) {
+                if (!contain(col)) {
+                    ++width;
+                    column.emplace_back(col);
+                    index.emplace(col, index.size());
+                    matrix.emplace_back(new column_array(std::move(array)));
+                } else {
+                    column_array &line = this->operator[](col);
+                    if (line.size() == array.size()) {
+                        line = array;
+                        rebuild_indexes();
+                    } else throw (std::invalid_argument("The length of the two is not the same"));
+                }
+                return true;
+            } else return false;
+        }
+
+        // insert one column from std::vector<T>
+        bool insert(const std::string &col, const column_array &array) {
+            if (array.size() == row_num()) {
+                if (!contain(col)) {
+                    ++width;
+                    column.emplace_back(col);
+                    index.emplace(col, index.size());
+                    matrix.emplace_back(new column_array(array));
+                } else {
+                    column_array &line = this->operator[](col);
+                    if (line.size() == array.size()) {
+                        line = array;
+                        rebuild_indexes();
+                    } else throw (std::invalid_argument("The length of the two is not the same"));
+                }
+                return true;
+            } else return false;
         }
 
         // insert one column from std::vector<T>
-        bool insert(const std::string &col, column_array &&array) {
+        bool insert(const std::string &col, std::vector<T> &&array) {
+            if (array.size() == row_num()) {
+                if (!contain(col)) {
+                    ++width;
+                    column.emplace_back(col);
+                    index.emplace(col, index.size());
+                    matrix.emplace_back(new column_array(array));
+                } else {
+                    column_array &line = this->operator[](col);
+                    if (line.size() == array.size()) {
+                        line = array;
+                        rebuild_indexes();
+                    } else throw (std::invalid_argument("The length of the two is not the same"));
+                }
+                return true;
+            } else return false;
+        }
+
+        // insert one column from std::vector<T>
+        bool insert(const std::string &col, const std::vector<T> &array) {
             if (array.size() == row_num()) {
                 if (!contain(col)) {
                     ++width;
@@ -542,207 +3564,1166 @@ namespace flame {
                     column_array &line = this->operator[](col);
                     if (line.size() == array.size()) {
                         line = array;
+                        rebuild_indexes();
                     } else throw (std::invalid_argument("The length of the two is not the same"));
                 }
                 return true;
             } else return false;
         }
 
-        // insert one column from std::vector<T>
-        bool insert(const std::string &col, const column_array &array) {
-            if (array.size() == row_num()) {
-                if (!contain(col)) {
-                    ++width;
-                    column.emplace_back(col);
-                    index.emplace(col, index.size());
-                    matrix.emplace_back(new column_array(array));
-                } else {
-                    column_array &line = this->operator[](col);
-                    if (line.size() == array.size()) {
-                        line = array;
-                    } else throw (std::invalid_argument("The length of the two is not the same"));
-                }
-                return true;
-            } else return false;
+        //remove one column from str
+        bool remove(const std::string &col) {
+            auto item = index.find(col);
+            if (item != index.end()) {
+                --width;
+                column.erase(column.begin() + item->second);
+                delete *(matrix.begin() + item->second);
+                matrix.erase(matrix.begin() + item->second);
+                for (auto &index_item : index) {
+                    if (index_item.second > item->second) {
+                        index_item.second--;
+                    }
+                }
+                indexes.erase(col);
+                index.erase(item);
+                return true;
+            }
+            return false;
+        }
+
+        //remove one row from index
+        bool remove(unsigned long long int i) {
+            if (i < length) {
+                for (auto &item : matrix) {
+                    item->erase(item->begin() + i);
+                }
+                --length;
+                rebuild_indexes();
+                return true;
+            } else {
+                return false;
+            }
+        }
+
+        // keep the rows whose flag in mask is true, every column is compacted in one pass and the columns are
+        // shared by up to threads threads (0 means all cores)
+        void filter(const std::vector<bool> &mask, unsigned int threads = 1) {
+            if (mask.size() != length)
+                throw (std::invalid_argument("The length of the two is not the same"));
+            toolbox::parallel_for(width, threads, [this, &mask](unsigned long long int i) {
+                matrix[i]->filter(mask);
+            });
+            length = std::count(mask.begin(), mask.end(), true);
+            rebuild_indexes();
+        }
+
+        // keep the rows where predicate is true for the value of column col, rows missing col are removed,
+        // a column which does not exist throws
+        template<typename Predicate>
+        void filter(const std::string &col, Predicate &&predicate, unsigned int threads = 1) {
+            filter(matrix[position(col)]->mask(std::forward<Predicate>(predicate)), threads);
+        }
+
+        // remove many rows at once, indices may come in any order and repeat
+        void remove_rows(const std::vector<unsigned long long int> &indices, unsigned int threads = 1) {
+            std::vector<bool> mask(length, true);
+            for (auto i : indices) {
+                if (i >= length) {
+                    std::stringstream ssTemp;
+                    ssTemp << i;
+                    throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+                }
+                mask[i] = false;
+            }
+            filter(mask, threads);
+        }
+
+        //get one row data from index of row
+        row_view operator[](unsigned long long int i) {
+            if (i < length)
+                return row_view(this, i);
+            else {
+                std::stringstream ssTemp;
+                ssTemp << i;
+                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            }
+        }
+
+        //get one row data from index of row
+        const_row_view operator[](unsigned long long int i) const {
+            if (i < length)
+                return const_row_view(this, i);
+            else {
+                std::stringstream ssTemp;
+                ssTemp << i;
+                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            }
+        }
+
+        // iterate over the rows as views, for (auto row : frame.rows())
+        [[nodiscard]] row_range<dataframe, row_view> rows() {
+            return row_range<dataframe, row_view>(this, 0, length);
+        }
+
+        [[nodiscard]] row_range<const dataframe, const_row_view> rows() const {
+            return row_range<const dataframe, const_row_view>(this, 0, length);
+        }
+
+        //get one column data from column str
+        column_array &operator[](const std::string &col) {
+            auto item = index.find(col);
+            if (item != index.end()) {
+                return *(matrix[item->second]);
+            }
+            insert(col);
+            return *(matrix.back());
+        }
+
+        //get one column data from column str
+        const column_array &operator[](const std::string &col) const {
+            auto item = index.find(col);
+            if (item != index.end()) {
+                return *(matrix[item->second]);
+            }
+            insert(col);
+            return *(matrix.back());
+        }
+
+        //get one column data from index of column
+        const column_array &operator()(unsigned long long int i) const {
+            if (i < matrix.size())
+                return *(matrix[i]);
+            std::stringstream ssTemp;
+            ssTemp << i;
+            throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+        }
+
+        //get one column data from index of column
+        column_array &operator()(unsigned long long int i) {
+            if (i < matrix.size())
+                return *(matrix[i]);
+            std::stringstream ssTemp;
+            ssTemp << i;
+            throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+        }
+
+        //append one row from std::vector<T>
+        bool append(const std::vector<T> &array) {
+            if (array.size() == width) {
+                length++;
+                for (unsigned long long int i = 0; i < array.size(); ++i) {
+                    matrix[i]->emplace_back(array[i]);
+                }
+                extend_indexes(length - 1);
+                return true;
+            } else return false;
+        }
+
+        //append one row from std::vector<T>
+        bool append(std::vector<T> &&array) {
+            if (array.size() == width) {
+                length++;
+                for (unsigned long long int i = 0; i < array.size(); ++i) {
+                    matrix[i]->emplace_back(std::move(array[i]));
+                }
+                extend_indexes(length - 1);
+                return true;
+            } else return false;
+        }
+
+        // append the rows of a row-major block, cells[i * column_num() + j] goes to the jth column of the ith row.
+        // the columns grow once for the block, which is transposed a tile at a time so that the tile is still in
+        // cache when it is read for the next column. false when the block does not hold whole rows
+        bool append_batch(const std::vector<T> &cells) {
+            return append_block(cells.size(), [&cells](unsigned long long int k) -> const T & { return cells[k]; });
+        }
+
+        bool append_batch(std::vector<T> &&cells) {
+            return append_block(cells.size(), [&cells](unsigned long long int k) -> T && {
+                return std::move(cells[k]);
+            });
+        }
+
+        // append one row per item of [first, last), the jth column takes fields[j] of the item, which is a pointer to
+        // a member or a function of the item. values are written straight into buffers of their own type, a tile
+        // of the items at a time. false when there is not one field per column
+        template<typename ForwardIt, typename... Fields>
+        bool append_batch(ForwardIt first, ForwardIt last, Fields &&... fields) {
+            if (sizeof...(Fields) != width)
+                return false;
+            const auto rows = (unsigned long long int) std::distance(first, last);
+            grow(length + rows);
+            typedef typename std::iterator_traits<ForwardIt>::value_type item_type;
+            const unsigned long long int tile = std::max<unsigned long long int>(1, tile_bytes / sizeof(item_type));
+            for (unsigned long long int begin = 0; begin < rows; begin += tile) {
+                ForwardIt tile_end = std::next(first, (long long int) std::min(tile, rows - begin));
+                unsigned long long int j = 0;
+                ([&] {
+                    column_array &array = *matrix[j++];
+                    for (auto item = first; item != tile_end; ++item)
+                        array.emplace_back_typed(std::invoke(fields, *item));
+                }(), ...);
+                first = tile_end;
+            }
+            length += rows;
+            extend_indexes(length - rows);
+            return true;
+        }
+
+        // make room for rows rows in every column
+        void reserve(unsigned long long int rows) {
+            for (auto &item : matrix) {
+                if (item->capacity() < rows)
+                    item->reserve(rows);
+            }
+        }
+
+        // bytes held by every column in the order of the columns, with the index of the column when it has one,
+        // deep walks the strings kept one by one as T cells like column_array::memory_usage
+        [[nodiscard]] std::vector<memory_footprint> column_memory_usage(bool deep = true) const {
+            std::vector<memory_footprint> result;
+            result.reserve(width);
+            for (unsigned long long int i = 0; i < width; ++i) {
+                result.emplace_back(matrix[i]->memory_usage(deep));
+                std::lock_guard<std::mutex> lock(index_mutex);
+                auto item = indexes.find(column[i]);
+                if (item != indexes.end())
+                    result.back().indexes = item->second->memory_usage();
+            }
+            return result;
+        }
+
+        // bytes held by the whole frame: its columns and indexes, the names of the columns and the tables
+        // that find them, rows are read through views so no row is held. buffers and indexes shared with a copy
+        // of the frame are counted by both
+        [[nodiscard]] memory_footprint memory_usage(bool deep = true) const {
+            memory_footprint result;
+            for (const auto &item : column_memory_usage(deep))
+                result += item;
+            result.add(column);
+            result.add(matrix);
+            result.payload += width * sizeof(column_array);
+            for (const auto &item : column)
+                result.strings += toolbox::heap_bytes(item);
+            // the nodes of the hash tables are estimated from their size
+            result.strings += index.bucket_count() * sizeof(void *) +
+                              index.size() * (sizeof(typename decltype(index)::value_type) + 2 * sizeof(void *));
+            result.indexes += indexes.size() * sizeof(column_index);
+            return result;
+        }
+
+        // release the capacity left beyond the rows by append, remove and filter in every column and index,
+        // buffers and indexes shared with a copy of the frame are left alone as shrinking them would copy them
+        void shrink_to_fit() {
+            for (auto &item : matrix)
+                item->shrink_to_fit();
+            for (auto &item : indexes) {
+                if (item.second.use_count() == 1)
+                    item.second->shrink_to_fit();
+            }
+            column.shrink_to_fit();
+            matrix.shrink_to_fit();
+        }
+
+        // shrink_to_fit after compacting every column: categories no cell uses are dropped, strings are trimmed
+        // and mixed columns which have come to hold one type get the buffer of that type
+        void compact() {
+            for (auto &item : matrix)
+                item->compact();
+            shrink_to_fit();
+        }
+
+        // rows collected in a row-major block, which is appended to the frame by append_batch whenever block_rows
+        // rows are waiting, and when the builder is flushed or destroyed. rows are only taken while the frame keeps
+        // the number of columns it had when the first waiting row was added
+        class row_builder {
+            dataframe *frame = nullptr;
+            std::vector<T> block;
+            unsigned long long int block_rows = 0;
+            // number of values in each waiting row
+            unsigned long long int width = 0;
+
+        public:
+            explicit row_builder(dataframe &_frame, unsigned long long int _block_rows = 4096) :
+                    frame(&_frame), block_rows(std::max<unsigned long long int>(1, _block_rows)) {
+                block.reserve(block_rows * frame->width);
+            }
+
+            row_builder(const row_builder &) = delete;
+
+            row_builder &operator=(const row_builder &) = delete;
+
+            // a destructor must not throw, so rows which can not be appended any more are dropped here,
+            // call flush before to be told about them
+            ~row_builder() {
+                try {
+                    flush();
+                } catch (...) {
+                }
+            }
+
+            // add one row, false when it does not hold one value per column
+            bool add(const std::vector<T> &row) {
+                if (!accept(row.size()))
+                    return false;
+                block.insert(block.end(), row.begin(), row.end());
+                flush_when_full();
+                return true;
+            }
+
+            bool add(std::vector<T> &&row) {
+                if (!accept(row.size()))
+                    return false;
+                std::move(row.begin(), row.end(), std::back_inserter(block));
+                flush_when_full();
+                return true;
+            }
+
+            // add one row from one value per column without building a std::vector
+            template<typename... Values>
+            bool emplace(Values &&... values) {
+                if (!accept(sizeof...(Values)))
+                    return false;
+                (block.emplace_back(std::forward<Values>(values)), ...);
+                flush_when_full();
+                return true;
+            }
+
+            [[nodiscard]] unsigned long long int pending() const {
+                return width == 0 ? 0 : block.size() / width;
+            }
+
+            // append the rows waiting in the block to the frame, they are kept and invalid_argument is thrown
+            // when the number of columns of the frame has changed since they were added
+            void flush() {
+                if (block.empty())
+                    return;
+                if (width != frame->width || !frame->append_batch(std::move(block)))
+                    throw (std::invalid_argument("the rows waiting in the builder do not match the columns"));
+                block.clear();
+            }
+
+        private:
+            // whether a row of n values can join the waiting rows, which must be flushed first when the number of
+            // columns of the frame has changed
+            bool accept(unsigned long long int n) {
+                if (n != frame->width)
+                    return false;
+                if (!block.empty() && width != n)
+                    flush();
+                width = n;
+                return true;
+            }
+
+            void flush_when_full() {
+                if (pending() >= block_rows)
+                    flush();
+            }
+        };
+
+        [[nodiscard]] const unsigned long long int &column_num() const {
+            return width;
+        }
+
+        [[nodiscard]] const unsigned long long int &row_num() const {
+            return length;
+        }
+
+        // count, mean, std, min and max of every column holding numbers, one row per statistic
+        // named in the first column
+        [[nodiscard]] dataframe<user_variant> describe() const {
+            return frame_view(*this).describe();
+        }
+
+        // a new dataframe with the same names whose column i is function(i, column i), the columns are built by
+        // up to threads threads (0 means all cores) and the source is never copied as a whole
+        template<typename Function>
+        [[nodiscard]] dataframe transform_columns(Function &&function, unsigned int threads = 1) const {
+            dataframe result(column, dataframe_name);
+            toolbox::parallel_for(width, threads, [&](unsigned long long int i) {
+                column_array array = function(i, *matrix[i]);
+                if (array.size() != length)
+                    throw (std::invalid_argument("The length of the two is not the same"));
+                delete result.matrix[i];
+                result.matrix[i] = new column_array(std::move(array));
+            });
+            result.length = length;
+            return result;
+        }
+
+        // rows [begin, end) of some of the columns of a dataframe, read in place until materialize copies them.
+        // the frame must outlive the view, and rows removed or reordered in the frame move under the view
+        class frame_view {
+            const dataframe *frame = nullptr;
+            std::vector<unsigned long long int> positions;
+            unsigned long long int first = 0;
+            unsigned long long int last = 0;
+
+            static void check_range(unsigned long long int begin, unsigned long long int end,
+                                    unsigned long long int length) {
+                if (begin > end || end > length) {
+                    std::stringstream ssTemp;
+                    ssTemp << begin << ", " << end;
+                    throw (std::out_of_range("the rows \'[" + ssTemp.str() + ")\' are out of range!"));
+                }
+            }
+
+        public:
+            // every row and column of _frame, so that a dataframe is accepted where a view is
+            frame_view(const dataframe &_frame) : frame(&_frame), positions(_frame.width), last(_frame.length) {
+                std::iota(positions.begin(), positions.end(), 0ULL);
+            }
+
+            frame_view(const dataframe &_frame, std::vector<unsigned long long int> _positions,
+                       unsigned long long int begin, unsigned long long int end) :
+                    frame(&_frame), positions(std::move(_positions)), first(begin), last(end) {
+                check_range(begin, end, _frame.length);
+            }
+
+            [[nodiscard]] unsigned long long int row_num() const {
+                return last - first;
+            }
+
+            [[nodiscard]] unsigned long long int column_num() const {
+                return positions.size();
+            }
+
+            // row of the frame where the view starts
+            [[nodiscard]] unsigned long long int offset() const {
+                return first;
+            }
+
+            [[nodiscard]] string_vector get_column_str() const {
+                string_vector names;
+                names.reserve(positions.size());
+                for (auto j : positions)
+                    names.emplace_back(frame->column[j]);
+                return names;
+            }
+
+            // the whole jth column of the view, its rows start at offset()
+            [[nodiscard]] const column_array &operator()(unsigned long long int j) const {
+                if (j < positions.size())
+                    return *frame->matrix[positions[j]];
+                std::stringstream ssTemp;
+                ssTemp << j;
+                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            }
+
+            // cell of the jth column in the ith row of the view
+            [[nodiscard]] T get(unsigned long long int i, unsigned long long int j) const {
+                if (i < row_num())
+                    return this->operator()(j).get(first + i);
+                std::stringstream ssTemp;
+                ssTemp << i;
+                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+            }
+
+            [[nodiscard]] frame_view head(unsigned long long int n) const {
+                return frame_view(*frame, positions, first, first + std::min(n, row_num()));
+            }
+
+            [[nodiscard]] frame_view tail(unsigned long long int n) const {
+                return frame_view(*frame, positions, last - std::min(n, row_num()), last);
+            }
+
+            // rows [begin, end) of the view
+            [[nodiscard]] frame_view slice(unsigned long long int begin, unsigned long long int end) const {
+                check_range(begin, end, row_num());
+                return frame_view(*frame, positions, first + begin, first + end);
+            }
+
+            // the columns named cols of the view, in the order of cols
+            [[nodiscard]] frame_view select(const string_vector &cols) const {
+                std::vector<unsigned long long int> selected;
+                for (const auto &col : cols) {
+                    auto j = frame->position(col);
+                    if (std::find(positions.begin(), positions.end(), j) == positions.end())
+                        throw (std::invalid_argument("the column '" + col + "' does not exist!"));
+                    selected.emplace_back(j);
+                }
+                return frame_view(*frame, std::move(selected), first, last);
+            }
+
+            // moments of the numbers of the jth column in the rows of the view
+            [[nodiscard]] toolbox::moments statistics(unsigned long long int j) const {
+                return this->operator()(j).statistics(first, last);
+            }
+
+            // count, mean, std, min and max of every column holding numbers, one row per statistic
+            // named in the first column, in a single pass over each column
+            [[nodiscard]] dataframe<user_variant> describe() const {
+                string_vector names{"statistic"};
+                std::vector<std::vector<user_variant>> rows;
+                for (const char *name : {"count", "mean", "std", "min", "max"})
+                    rows.emplace_back(1, std::string(name));
+                for (unsigned long long int j = 0; j < positions.size(); ++j) {
+                    auto stats = statistics(j);
+                    if (stats.count == 0)
+                        continue;
+                    double var = stats.count < 2 ? std::numeric_limits<double>::quiet_NaN() :
+                                 stats.m2 / double(stats.count - 1);
+                    names.emplace_back(frame->column[positions[j]]);
+                    rows[0].emplace_back(double(stats.count));
+                    rows[1].emplace_back(stats.mean);
+                    rows[2].emplace_back(std::sqrt(var));
+                    rows[3].emplace_back(stats.min);
+                    rows[4].emplace_back(stats.max);
+                }
+                dataframe<user_variant> summary(names, "describe");
+                for (auto &row : rows)
+                    summary.append(std::move(row));
+                return summary;
+            }
+
+            void to_csv(const std::string &filename, const char &delimiter = ',', unsigned int threads = 1) const {
+                std::vector<const column_array *> arrays;
+                for (auto j : positions)
+                    arrays.emplace_back(frame->matrix[j]);
+                write_csv(filename, get_column_str(), arrays, first, last, delimiter, threads);
+            }
+
+            // a dataframe holding the rows and columns of the view, which shares the column buffers
+            // of the frame when the view covers all of its rows
+            [[nodiscard]] dataframe materialize() const {
+                dataframe result(get_column_str(), frame->dataframe_name);
+                for (unsigned long long int j = 0; j < positions.size(); ++j) {
+                    delete result.matrix[j];
+                    result.matrix[j] = new column_array(frame->matrix[positions[j]]->sliced(first, last));
+                }
+                result.length = row_num();
+                return result;
+            }
+        };
+
+        // the first n rows, or all of them when there are fewer, without copying
+        [[nodiscard]] frame_view head(unsigned long long int n) const {
+            return frame_view(*this).head(n);
+        }
+
+        // the last n rows, or all of them when there are fewer, without copying
+        [[nodiscard]] frame_view tail(unsigned long long int n) const {
+            return frame_view(*this).tail(n);
         }
 
-        // insert one column from std::vector<T>
-        bool insert(const std::string &col, std::vector<T> &&array) {
-            if (array.size() == row_num()) {
-                if (!contain(col)) {
-                    ++width;
-                    column.emplace_back(col);
-                    index.emplace(col, index.size());
-                    matrix.emplace_back(new column_array(array));
-                } else {
-                    column_array &line = this->operator[](col);
-                    if (line.size() == array.size()) {
-                        line = array;
-                    } else throw (std::invalid_argument("The length of the two is not the same"));
+        // rows [begin, end) without copying
+        [[nodiscard]] frame_view slice(unsigned long long int begin, unsigned long long int end) const {
+            return frame_view(*this).slice(begin, end);
+        }
+
+        // the columns named cols in the order of cols, without copying
+        [[nodiscard]] frame_view select(const string_vector &cols) const {
+            return frame_view(*this).select(cols);
+        }
+
+    private:
+        // bytes of the rows transposed at once by append_batch, which fit in the first level cache
+        static constexpr unsigned long long int tile_bytes = 1 << 15;
+
+        // make room for rows rows in every column, growing geometrically so that batches appended one after
+        // the other do not move the buffers each time
+        void grow(unsigned long long int rows) {
+            for (auto &item : matrix) {
+                auto capacity = item->capacity();
+                if (capacity < rows)
+                    item->reserve(std::max(rows, 2 * capacity));
+            }
+        }
+
+        // append the rows of a row-major block of n cells, cell(k) gives the kth one
+        template<typename Cell>
+        bool append_block(unsigned long long int n, Cell &&cell) {
+            if (width == 0 || n % width != 0)
+                return n == 0;
+            const unsigned long long int rows = n / width;
+            grow(length + rows);
+            const unsigned long long int tile = std::max<unsigned long long int>(1, tile_bytes / (sizeof(T) * width));
+            for (unsigned long long int begin = 0; begin < rows; begin += tile) {
+                const unsigned long long int end = std::min(rows, begin + tile);
+                for (unsigned long long int j = 0; j < width; ++j) {
+                    column_array &array = *matrix[j];
+                    for (unsigned long long int i = begin; i < end; ++i)
+                        array.emplace_back(cell(i * width + j));
                 }
-                return true;
-            } else return false;
+            }
+            length += rows;
+            extend_indexes(length - rows);
+            return true;
         }
 
-        // insert one column from std::vector<T>
-        bool insert(const std::string &col, const std::vector<T> &array) {
-            if (array.size() == row_num()) {
-                if (!contain(col)) {
-                    ++width;
-                    column.emplace_back(col);
-                    index.emplace(col, index.size());
-                    matrix.emplace_back(new column_array(array));
-                } else {
-                    column_array &line = this->operator[](col);
-                    if (line.size() == array.size()) {
-                        line = array;
-                    } else throw (std::invalid_argument("The length of the two is not the same"));
+    private:
+        static dataframe concat_frames(const std::vector<const dataframe *> &frames, unsigned int threads) {
+            if (frames.empty())
+                return dataframe();
+            const dataframe &first = *frames.front();
+            unsigned long long int total = 0;
+            for (const auto *frame : frames) {
+                if (frame->width != first.width)
+                    throw (std::invalid_argument("The column length of the two is not the same"));
+                total += frame->length;
+            }
+            dataframe result(first.column, first.dataframe_name);
+            toolbox::parallel_for(first.width, threads, [&](unsigned long long int i) {
+                column_array &target = *result.matrix[i];
+                bool reserved = false;
+                for (const auto *frame : frames) {
+                    target.append(*frame->matrix[i]);
+                    // append shares the first part, its copy is made once with room for all the others
+                    if (!reserved && target.size() != 0 && target.size() != total) {
+                        target.reserve(total);
+                        reserved = true;
+                    }
                 }
-                return true;
-            } else return false;
+            });
+            result.length = total;
+            return result;
         }
 
-        //remove one column from str
-        bool remove(const std::string &col) {
-            auto item = index.find(col);
-            if (item != index.end()) {
-                --width;
-                column.erase(column.begin() + item->second);
-                delete *(matrix.begin() + item->second);
-                matrix.erase(matrix.begin() + item->second);
-                for (auto &index_item : index) {
-                    if (index_item.second > item->second) {
-                        index_item.second--;
+    private:
+        // open addressing table from the keys of a row to its group, a group is known by its first row
+        struct group_table {
+            std::vector<unsigned long long int> slots = std::vector<unsigned long long int>(16, 0);
+            std::vector<unsigned long long int> rows;
+            std::vector<std::uint64_t> hashes;
+
+            // group of row, a new group when no row before has the same keys
+            template<typename Same>
+            unsigned long long int find(unsigned long long int row, std::uint64_t hash, Same &&same) {
+                if ((rows.size() + 1) * 2 > slots.size())
+                    grow();
+                const unsigned long long int mask = slots.size() - 1;
+                for (unsigned long long int k = hash & mask;; k = (k + 1) & mask) {
+                    if (slots[k] == 0) {
+                        rows.emplace_back(row);
+                        hashes.emplace_back(hash);
+                        slots[k] = rows.size();
+                        return rows.size() - 1;
                     }
+                    unsigned long long int group = slots[k] - 1;
+                    if (hashes[group] == hash && same(rows[group], row))
+                        return group;
                 }
-                index.erase(item);
-                return true;
             }
-            return false;
-        }
 
-        //remove one row from index
-        bool remove(unsigned long long int i) {
-            if (i < length) {
-                for (auto &item : matrix) {
-                    item->erase(item->begin() + i);
+            // group whose first row is the same as a row of hash for same, rows.size() when there is none
+            template<typename Same>
+            [[nodiscard]] unsigned long long int lookup(std::uint64_t hash, Same &&same) const {
+                const unsigned long long int mask = slots.size() - 1;
+                for (unsigned long long int k = hash & mask; slots[k] != 0; k = (k + 1) & mask) {
+                    unsigned long long int group = slots[k] - 1;
+                    if (hashes[group] == hash && same(rows[group]))
+                        return group;
                 }
-                --length;
-                return true;
-            } else {
-                return false;
+                return rows.size();
             }
-        }
 
-        //get one row data from index of row
-        row_array operator[](unsigned long long int i) {
-            if (i < length) {
-                row_array row_array;
-                for (auto &item : matrix) {
-                    row_array.push_back(&((*item)[i]));
+            void grow() {
+                slots.assign(slots.size() * 2, 0);
+                const unsigned long long int mask = slots.size() - 1;
+                for (unsigned long long int group = 0; group < rows.size(); ++group) {
+                    unsigned long long int k = hashes[group] & mask;
+                    while (slots[k] != 0)
+                        k = (k + 1) & mask;
+                    slots[k] = group + 1;
                 }
-                return std::move(row_array);
-            } else {
-                std::stringstream ssTemp;
-                ssTemp << i;
-                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
             }
-        }
+        };
 
-        //get one row data from index of row
-        row_array operator[](unsigned long long int i) const {
-            if (i < length) {
-                row_array row_array;
-                for (auto &item : matrix) {
-                    row_array.push_back(&((*item)[i]));
+        // secondary index of one column, the rows which are missing the value are left out
+        struct column_index {
+            index_type type = hash_index;
+            // version of the column when the index was last brought up to date, a column written to since then
+            // gets the index built again by the next lookup or change of its rows
+            unsigned long long int version = 0;
+            // hash index: groups of equal values, the rows of a group are chained from its first row to last
+            group_table table;
+            std::vector<unsigned long long int> next;
+            std::vector<unsigned long long int> last;
+            // sorted index: rows in the order of their values, equal values in the order of the rows
+            std::vector<unsigned long long int> order;
+
+            // add rows [begin, end) of array, which follow the rows already indexed
+            void add(const column_array &array, unsigned long long int begin, unsigned long long int end) {
+                const auto none = column_array::missing_row;
+                if (type == hash_index) {
+                    std::vector<std::uint64_t> hashes(end - begin, 0);
+                    array.hash_cells(begin, end, hashes.data());
+                    next.resize(end, none);
+                    for (unsigned long long int i = begin; i < end; ++i) {
+                        if (array.is_null(i))
+                            continue;
+                        auto group = table.find(i, hashes[i - begin], [&array](auto a, auto b) {
+                            return array.same_cells(a, b);
+                        });
+                        if (group == last.size()) {
+                            last.emplace_back(i);
+                        } else {
+                            next[last[group]] = i;
+                            last[group] = i;
+                        }
+                    }
+                } else {
+                    std::vector<unsigned long long int> rows;
+                    for (unsigned long long int i = begin; i < end; ++i) {
+                        if (!array.is_null(i))
+                            rows.emplace_back(i);
+                    }
+                    array.sort_rows(rows, true, 1);
+                    std::vector<unsigned long long int> merged;
+                    merged.reserve(order.size() + rows.size());
+                    std::merge(order.begin(), order.end(), rows.begin(), rows.end(), std::back_inserter(merged),
+                               [&array](auto a, auto b) { return array.compare_cells(a, b) < 0; });
+                    order.swap(merged);
                 }
-                return std::move(row_array);
-            } else {
-                std::stringstream ssTemp;
-                ssTemp << i;
-                throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
             }
+
+            // bytes of the index with the capacity of its tables
+            [[nodiscard]] unsigned long long int memory_usage() const {
+                unsigned long long int bytes = 0;
+                for (const auto *rows : {&table.slots, &table.rows, &next, &last, &order})
+                    bytes += rows->capacity() * sizeof(unsigned long long int);
+                return bytes + table.hashes.capacity() * sizeof(std::uint64_t);
+            }
+
+            void shrink_to_fit() {
+                table.rows.shrink_to_fit();
+                table.hashes.shrink_to_fit();
+                next.shrink_to_fit();
+                last.shrink_to_fit();
+                order.shrink_to_fit();
+            }
+
+            // a new index of the same type over all rows of array
+            [[nodiscard]] std::shared_ptr<column_index> rebuilt(const column_array &array) const {
+                auto fresh = std::make_shared<column_index>();
+                fresh->type = type;
+                fresh->version = array.version();
+                fresh->add(array, 0, array.size());
+                return fresh;
+            }
+        };
+
+        // rebuild every index after the rows have been changed other than by appending
+        void rebuild_indexes() {
+            for (auto &item : indexes)
+                item.second = item.second->rebuilt(*matrix[position(item.first)]);
         }
 
-        //get one column data from column str
-        column_array &operator[](const std::string &col) {
-            auto item = index.find(col);
-            if (item != index.end()) {
-                return *(matrix[item->second]);
+        // index the rows appended from begin, an index shared with a copy of the frame is copied first
+        // and a stale index is built again
+        void extend_indexes(unsigned long long int begin) {
+            for (auto &item : indexes) {
+                const column_array &array = *matrix[position(item.first)];
+                if (item.second->version != array.version()) {
+                    item.second = item.second->rebuilt(array);
+                    continue;
+                }
+                if (item.second.use_count() > 1)
+                    item.second = std::make_shared<column_index>(*item.second);
+                item.second->add(array, begin, length);
             }
-            insert(col);
-            return *(matrix.back());
         }
 
-        //get one column data from column str
-        const column_array &operator[](const std::string &col) const {
-            auto item = index.find(col);
-            if (item != index.end()) {
-                return *(matrix[item->second]);
+    public:
+        // rows of a dataframe grouped by the values of key columns, made by group_by
+        class grouped_frame {
+            friend class dataframe;
+
+            // groups of one chunk of rows with the statistics of the aggregated columns
+            struct partial_groups {
+                group_table table;
+                std::vector<std::vector<toolbox::moments>> statistics;
+                std::vector<std::vector<double>> sums;
+            };
+
+            grouped_frame(const dataframe &frame, std::vector<unsigned long long int> keys) :
+                    frame(&frame), keys(std::move(keys)) {}
+
+            const dataframe *frame;
+            std::vector<unsigned long long int> keys;
+
+        public:
+            // one row per group in the order the groups first appear: the keys, then one column named
+            // col_aggregate per pair. chunks of rows are grouped into partial tables by up to threads threads
+            // (0 means all cores), which are merged at the end
+            [[nodiscard]] dataframe<user_variant>
+            agg(const std::vector<std::pair<std::string, aggregate_type>> &aggregates, unsigned int threads = 1) const {
+                const auto &matrix = frame->matrix;
+                const unsigned long long int length = frame->length;
+                // every column is accumulated once however many aggregates it has
+                std::vector<unsigned long long int> sources, slot_of;
+                for (const auto &item : aggregates) {
+                    auto i = frame->position(item.first);
+                    auto found = std::find(sources.begin(), sources.end(), i);
+                    slot_of.emplace_back(found - sources.begin());
+                    if (found == sources.end())
+                        sources.emplace_back(i);
+                }
+                auto same = [this, &matrix](unsigned long long int a, unsigned long long int b) {
+                    for (auto k : keys) {
+                        if (!matrix[k]->same_cells(a, b))
+                            return false;
+                    }
+                    return true;
+                };
+
+                if (threads == 0)
+                    threads = std::max(1u, std::thread::hardware_concurrency());
+                // small chunks are not worth a table of their own
+                const unsigned long long int min_chunk = 1 << 16;
+                const unsigned long long int chunks =
+                        std::max<unsigned long long int>(1, std::min<unsigned long long int>(threads,
+                                                                                            length / min_chunk));
+                const unsigned long long int chunk_size = (length + chunks - 1) / chunks;
+                std::vector<partial_groups> parts(chunks);
+                toolbox::parallel_for(chunks, threads, [&](unsigned long long int chunk) {
+                    const unsigned long long int begin = std::min(length, chunk * chunk_size);
+                    const unsigned long long int end = std::min(length, begin + chunk_size);
+                    auto &part = parts[chunk];
+                    std::vector<std::uint64_t> hashes(end - begin, 0);
+                    for (auto k : keys)
+                        matrix[k]->hash_cells(begin, end, hashes.data());
+                    std::vector<unsigned long long int> groups(end - begin);
+                    for (unsigned long long int i = begin; i < end; ++i)
+                        groups[i - begin] = part.table.find(i, hashes[i - begin], same);
+                    for (auto i : sources) {
+                        part.statistics.emplace_back(part.table.rows.size());
+                        part.sums.emplace_back(part.table.rows.size(), 0);
+                        matrix[i]->accumulate(begin, end, groups.data(), part.statistics.back().data(),
+                                              part.sums.back().data());
+                    }
+                });
+
+                // merge the partial tables in row order, so that the groups keep the order of their first row
+                partial_groups result;
+                result.statistics.resize(sources.size());
+                result.sums.resize(sources.size());
+                for (auto &part : parts) {
+                    for (unsigned long long int group = 0; group < part.table.rows.size(); ++group) {
+                        auto target = result.table.find(part.table.rows[group], part.table.hashes[group], same);
+                        for (unsigned long long int j = 0; j < sources.size(); ++j) {
+                            if (target == result.statistics[j].size()) {
+                                result.statistics[j].emplace_back();
+                                result.sums[j].emplace_back(0);
+                            }
+                            result.statistics[j][target].merge(part.statistics[j][group]);
+                            result.sums[j][target] += part.sums[j][group];
+                        }
+                    }
+                }
+
+                std::vector<std::string> names;
+                for (auto k : keys)
+                    names.emplace_back(frame->column[k]);
+                for (const auto &item : aggregates)
+                    names.emplace_back(aggregate_name(item.first, item.second));
+                dataframe<user_variant> grouped(names, "group_by");
+                const auto &rows = result.table.rows;
+                for (unsigned long long int j = 0; j < keys.size(); ++j) {
+                    auto &array = *grouped.matrix[j];
+                    for (auto row : rows) {
+                        if (matrix[keys[j]]->is_null(row))
+                            array.emplace_null();
+                        else array.emplace_back(user_variant(matrix[keys[j]]->get(row)));
+                    }
+                }
+                for (unsigned long long int j = 0; j < aggregates.size(); ++j) {
+                    auto &array = *grouped.matrix[keys.size() + j];
+                    array.reserve(rows.size());
+                    for (unsigned long long int group = 0; group < rows.size(); ++group)
+                        array.emplace_back_typed(aggregate_value(result.statistics[slot_of[j]][group],
+                                                                 result.sums[slot_of[j]][group],
+                                                                 aggregates[j].second));
+                }
+                grouped.length = rows.size();
+                return grouped;
             }
-            insert(col);
-            return *(matrix.back());
+        };
+
+        // group the rows by the values of the key columns, a missing key is a value of its own
+        [[nodiscard]] grouped_frame group_by(const std::vector<std::string> &keys) const {
+            std::vector<unsigned long long int> positions;
+            for (const auto &key : keys)
+                positions.emplace_back(position(key));
+            return grouped_frame(*this, std::move(positions));
         }
 
-        //get one column data from index of column
-        const column_array &operator()(unsigned long long int i) const {
-            if (i < matrix.size())
-                return *(matrix[i]);
-            std::stringstream ssTemp;
-            ssTemp << i;
-            throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+        // build a secondary index on col, which replaces the index col had. the index follows append, concat_line,
+        // remove, filter and sort_by. after a cell is written through a reference to a row or to the column,
+        // the first lookup or range builds the index again over the whole column
+        void create_index(const std::string &col, index_type type = hash_index) {
+            const column_array &array = *matrix[position(col)];
+            auto created = std::make_shared<column_index>();
+            created->type = type;
+            created->version = array.version();
+            created->add(array, 0, length);
+            indexes[col] = std::move(created);
         }
 
-        //get one column data from index of column
-        column_array &operator()(unsigned long long int i) {
-            if (i < matrix.size())
-                return *(matrix[i]);
-            std::stringstream ssTemp;
-            ssTemp << i;
-            throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
+        bool drop_index(const std::string &col) {
+            return indexes.erase(col) != 0;
         }
 
-        //append one row from std::vector<T>
-        bool append(const std::vector<T> &array) {
-            if (array.size() == width) {
-                length++;
-                for (unsigned long long int i = 0; i < array.size(); ++i) {
-                    matrix[i]->emplace_back(array[i]);
+        // the index of col, nullptr without one. an index left behind by a write to the column is built again
+        // first, under index_mutex as lookups of one frame may run at the same time
+        [[nodiscard]] const column_index *current_index(const std::string &col, const column_array &array) const {
+            std::lock_guard<std::mutex> lock(index_mutex);
+            auto item = indexes.find(col);
+            if (item == indexes.end())
+                return nullptr;
+            if (item->second->version != array.version())
+                item->second = item->second->rebuilt(array);
+            return item->second.get();
+        }
+
+        // the indexes for a copy of the frame, read under index_mutex as current_index may replace one
+        [[nodiscard]] std::unordered_map<std::string, std::shared_ptr<column_index>> shared_indexes() const {
+            std::lock_guard<std::mutex> lock(index_mutex);
+            return indexes;
+        }
+
+        // rows holding value in col in ascending order, found by the index of col or by a scan without one.
+        // numbers are equal when their values are, so 5 finds the rows of a long column holding 5
+        [[nodiscard]] std::vector<unsigned long long int> lookup(const std::string &col, const T &value) const {
+            const column_array &array = *matrix[position(col)];
+            std::vector<unsigned long long int> rows;
+            auto holds = [&array, &value](unsigned long long int row) { return array.holds_value(row, value); };
+            const column_index *found = current_index(col, array);
+            if (found == nullptr) {
+                for (unsigned long long int i = 0; i < length; ++i) {
+                    if (holds(i))
+                        rows.emplace_back(i);
                 }
-                return true;
-            } else return false;
+            } else if (found->type == hash_index) {
+                // numbers hash by their value, so the rows of every type holding it are in one group
+                auto group = found->table.lookup(column_array::hash_of(value), holds);
+                if (group != found->table.rows.size()) {
+                    for (auto row = found->table.rows[group]; row != column_array::missing_row; row = found->next[row])
+                        rows.emplace_back(row);
+                }
+            } else {
+                const auto &order = found->order;
+                auto first = std::lower_bound(order.begin(), order.end(), value, [&array](auto row, const T &v) {
+                    return array.compare_value(row, v) < 0;
+                });
+                for (; first != order.end() && array.compare_value(*first, value) == 0; ++first) {
+                    if (holds(*first))
+                        rows.emplace_back(*first);
+                }
+                std::sort(rows.begin(), rows.end());
+            }
+            return rows;
         }
 
-        //append one row from std::vector<T>
-        bool append(std::vector<T> &&array) {
-            if (array.size() == width) {
-                length++;
-                for (unsigned long long int i = 0; i < array.size(); ++i) {
-                    matrix[i]->emplace_back(std::move(array[i]));
+        // rows whose value in col is between low and high, both included, in ascending order. numbers are
+        // compared as numbers and come before words, a sorted index of col is used when there is one
+        [[nodiscard]] std::vector<unsigned long long int> range(const std::string &col, const T &low,
+                                                                const T &high) const {
+            const column_array &array = *matrix[position(col)];
+            std::vector<unsigned long long int> rows;
+            const column_index *found = current_index(col, array);
+            if (found != nullptr && found->type == sorted_index) {
+                const auto &order = found->order;
+                auto first = std::lower_bound(order.begin(), order.end(), low, [&array](auto row, const T &v) {
+                    return array.compare_value(row, v) < 0;
+                });
+                auto last = std::upper_bound(first, order.end(), high, [&array](const T &v, auto row) {
+                    return array.compare_value(row, v) > 0;
+                });
+                rows.assign(first, last);
+                std::sort(rows.begin(), rows.end());
+            } else {
+                for (unsigned long long int i = 0; i < length; ++i) {
+                    if (!array.is_null(i) && array.compare_value(i, low) >= 0 && array.compare_value(i, high) <= 0)
+                        rows.emplace_back(i);
                 }
-                return true;
-            } else return false;
+            }
+            return rows;
         }
 
-        [[nodiscard]] const unsigned long long int &column_num() const {
-            return width;
+        // sort the rows by the values of cols, the first column first, equal rows keep their order and missing
+        // values go last. the permutation is found column by column from the last one, by radix sort for numbers
+        // and categories and by a merge sort over up to threads threads (0 means all cores) for other columns,
+        // then the columns are gathered through it in parallel
+        void sort_by(const std::vector<std::string> &cols, bool ascending = true, unsigned int threads = 1) {
+            std::vector<unsigned long long int> positions;
+            for (const auto &col : cols)
+                positions.emplace_back(position(col));
+            std::vector<unsigned long long int> rows(length);
+            std::iota(rows.begin(), rows.end(), 0);
+            for (auto i = positions.rbegin(); i != positions.rend(); ++i)
+                matrix[*i]->sort_rows(rows, ascending, threads);
+            toolbox::parallel_for(width, threads, [this, &rows](unsigned long long int i) {
+                matrix[i]->gather(rows);
+            });
+            rebuild_indexes();
         }
 
-        [[nodiscard]] const unsigned long long int &row_num() const {
-            return length;
+        // join the rows of other whose on columns hold the same values, a missing key matches nothing.
+        // the columns of this dataframe come first, then those of other but its on columns, a name which is
+        // already used gets "_r" like in concat_row. the rows follow this dataframe, then other.
+        // the smaller dataframe of an inner join is put into a hash table, the other one is probed by up to
+        // threads threads (0 means all cores), a left join always builds on other
+        [[nodiscard]] dataframe join(const dataframe &other, const std::vector<std::string> &on,
+                                     join_type how = inner_join, unsigned int threads = 1) const {
+            std::vector<unsigned long long int> left_keys, right_keys;
+            for (const auto &col : on) {
+                left_keys.emplace_back(position(col));
+                right_keys.emplace_back(other.position(col));
+            }
+            const bool build_left = how == inner_join && length < other.length;
+            const dataframe &build = build_left ? *this : other;
+            const dataframe &probe = build_left ? other : *this;
+            const auto &build_keys = build_left ? left_keys : right_keys;
+            const auto &probe_keys = build_left ? right_keys : left_keys;
+            const auto none = column_array::missing_row;
+
+            // rows of the build side with the same keys are chained behind the first one
+            group_table table;
+            std::vector<unsigned long long int> next(build.length, none), last;
+            {
+                std::vector<std::uint64_t> hashes(build.length, 0);
+                for (auto k : build_keys)
+                    build.matrix[k]->hash_cells(0, build.length, hashes.data());
+                auto same = [&](unsigned long long int a, unsigned long long int b) {
+                    for (auto k : build_keys) {
+                        if (!build.matrix[k]->same_cells(a, b))
+                            return false;
+                    }
+                    return true;
+                };
+                for (unsigned long long int i = 0; i < build.length; ++i) {
+                    if (std::any_of(build_keys.begin(), build_keys.end(),
+                                    [&](unsigned long long int k) { return build.matrix[k]->is_null(i); }))
+                        continue;
+                    auto group = table.find(i, hashes[i], same);
+                    if (group == last.size())
+                        last.emplace_back(i);
+                    else {
+                        next[last[group]] = i;
+                        last[group] = i;
+                    }
+                }
+            }
+
+            // each chunk of the probe side gives its pairs of (probe row, build row) in probe order
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            const unsigned long long int min_chunk = 1 << 16;
+            const unsigned long long int chunks =
+                    std::max<unsigned long long int>(1, std::min<unsigned long long int>(threads,
+                                                                                        probe.length / min_chunk));
+            const unsigned long long int chunk_size = (probe.length + chunks - 1) / chunks;
+            std::vector<std::vector<std::pair<unsigned long long int, unsigned long long int>>> parts(chunks);
+            toolbox::parallel_for(chunks, threads, [&](unsigned long long int chunk) {
+                const unsigned long long int begin = std::min(probe.length, chunk * chunk_size);
+                const unsigned long long int end = std::min(probe.length, begin + chunk_size);
+                std::vector<std::uint64_t> hashes(end - begin, 0);
+                for (auto k : probe_keys)
+                    probe.matrix[k]->hash_cells(begin, end, hashes.data());
+                auto &pairs = parts[chunk];
+                for (unsigned long long int i = begin; i < end; ++i) {
+                    auto group = table.lookup(hashes[i - begin], [&](unsigned long long int row) {
+                        for (unsigned long long int k = 0; k < probe_keys.size(); ++k) {
+                            if (probe.matrix[probe_keys[k]]->is_null(i) ||
+                                !build.matrix[build_keys[k]]->same_cell(row, *probe.matrix[probe_keys[k]], i))
+                                return false;
+                        }
+                        return true;
+                    });
+                    if (group == table.rows.size()) {
+                        if (how == left_join)
+                            pairs.emplace_back(i, none);
+                        continue;
+                    }
+                    for (auto row = table.rows[group]; row != none; row = next[row])
+                        pairs.emplace_back(i, row);
+                }
+            });
+
+            std::vector<unsigned long long int> left_rows, right_rows;
+            for (const auto &pairs : parts) {
+                for (const auto &item : pairs) {
+                    left_rows.emplace_back(build_left ? item.second : item.first);
+                    right_rows.emplace_back(build_left ? item.first : item.second);
+                }
+            }
+            // probing other gives its order, a stable counting sort on the rows of this dataframe restores theirs
+            if (build_left) {
+                std::vector<unsigned long long int> starts(length + 1, 0);
+                for (auto row : left_rows)
+                    ++starts[row + 1];
+                std::partial_sum(starts.begin(), starts.end(), starts.begin());
+                std::vector<unsigned long long int> sorted_left(left_rows.size()), sorted_right(right_rows.size());
+                for (unsigned long long int i = 0; i < left_rows.size(); ++i) {
+                    auto k = starts[left_rows[i]]++;
+                    sorted_left[k] = left_rows[i];
+                    sorted_right[k] = right_rows[i];
+                }
+                left_rows.swap(sorted_left);
+                right_rows.swap(sorted_right);
+            }
+
+            string_vector names(column);
+            std::vector<std::pair<const column_array *, const std::vector<unsigned long long int> *>> sources;
+            for (unsigned long long int i = 0; i < width; ++i)
+                sources.emplace_back(matrix[i], &left_rows);
+            for (unsigned long long int i = 0; i < other.width; ++i) {
+                if (std::find(right_keys.begin(), right_keys.end(), i) != right_keys.end())
+                    continue;
+                bool repeat = std::find(names.begin(), names.end(), other.column[i]) != names.end();
+                names.emplace_back(other.column[i] + (repeat ? "_r" : ""));
+                sources.emplace_back(other.matrix[i], &right_rows);
+            }
+            dataframe result(names, dataframe_name);
+            toolbox::parallel_for(sources.size(), threads, [&](unsigned long long int i) {
+                column_array array = sources[i].first->gathered(*sources[i].second);
+                delete result.matrix[i];
+                result.matrix[i] = new column_array(std::move(array));
+            });
+            result.length = left_rows.size();
+            return result;
         }
 
         //concat double dataframe object vertically
         bool concat_line(const dataframe &dataframe) {
             if (dataframe.width == width) {
+                const unsigned long long int begin = length;
+                length += dataframe.length;
+                for (unsigned long long int i = 0; i < width; ++i) {
+                    matrix[i]->append(dataframe(i));
+                }
+                extend_indexes(begin);
+                return true;
+            } else return false;
+        }
+
+        //concat double dataframe object vertically, a column of this dataframe which is empty takes over the buffer
+        //of the other one instead of copying it
+        bool concat_line(dataframe &&dataframe) {
+            if (this == &dataframe)
+                return concat_line(std::as_const(dataframe));
+            if (dataframe.width == width) {
+                const unsigned long long int begin = length;
                 length += dataframe.length;
                 for (unsigned long long int i = 0; i < width; ++i) {
-                    matrix[i]->insert(matrix[i]->end(), dataframe(i).begin(), dataframe(i).end());
+                    matrix[i]->append(std::move(*dataframe.matrix[i]));
                 }
+                extend_indexes(begin);
+                dataframe.clear_rows();
                 return true;
             } else return false;
         }
 
+        // all rows of frames one after the other, each column is sized once for all of them and filled by
+        // one of up to threads threads (0 means all cores)
+        [[nodiscard]] static dataframe concat(const std::vector<dataframe> &frames, unsigned int threads = 1) {
+            std::vector<const dataframe *> parts;
+            for (const auto &frame : frames)
+                parts.emplace_back(&frame);
+            return concat_frames(parts, threads);
+        }
+
         //concat double dataframe object horizontally
         bool concat_row(const dataframe &dataframe) {
             if (dataframe.length == length) {
@@ -775,6 +4756,15 @@ namespace flame {
             } else return false;
         }
 
+        // remove all rows but keep the columns and their buffers
+        void clear_rows() {
+            length = 0;
+            for (auto &item : matrix) {
+                item->clear();
+            }
+            rebuild_indexes();
+        }
+
         // is empty or not
         bool empty() const {
             return width == 0 || length == 0;
@@ -784,11 +4774,9 @@ namespace flame {
         friend dataframe operator+(const dataframe &dataframe1, const dataframe &dataframe2) {
             if (!dataframe1.empty() && !dataframe2.empty() &&
                 dataframe1.column_num() == dataframe2.column_num()) {
-                dataframe dataFrame(dataframe1.column);
-                dataFrame.concat_line(dataframe1);
-                dataFrame.concat_line(dataframe2);
+                dataframe dataFrame = concat_frames({&dataframe1, &dataframe2}, 1);
                 dataFrame.dataframe_name = dataframe1.dataframe_name + "&" + dataframe2.dataframe_name;
-                return std::move(dataFrame);
+                return dataFrame;
             } else throw (std::invalid_argument("The column length of the two is not the same"));
         }
 
@@ -799,13 +4787,12 @@ namespace flame {
             clear();
             width = dataframe.width;
             length = dataframe.length;
-            dataframe_name = dataframe.dataframe_name;
+            dataframe_name = std::move(dataframe.dataframe_name);
             column = std::move(dataframe.column);
             index = std::move(dataframe.index);
-            matrix.clear();
-            for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
-                matrix.emplace_back(new column_array(std::move(**i)));
-            }
+            indexes = std::move(dataframe.indexes);
+            matrix.swap(dataframe.matrix);
+            dataframe.clear();
             return *this;
         }
 
@@ -818,6 +4805,7 @@ namespace flame {
             length = dataframe.length;
             column = dataframe.column;
             index = dataframe.index;
+            indexes = dataframe.shared_indexes();
             dataframe_name = dataframe.dataframe_name;
             matrix.clear();
             for (auto i = dataframe.matrix.begin(); i < dataframe.matrix.end(); ++i) {
@@ -826,67 +4814,225 @@ namespace flame {
             return *this;
         }
 
-        //read from csv file
-        void read_csv(const std::string &filename, const char &delimiter = ',') {
+        //read from csv file, the rows are parsed by several threads when threads is not 1 (0 means all cores),
+        //the type of each column is taken from schema or inferred from the first sample_rows rows
+        void read_csv(const std::string &filename, const char &delimiter = ',', unsigned int threads = 1,
+                      const csv_schema &schema = {}, unsigned long long int sample_rows = 1000) {
+            check_schema(schema);
             clear();
-            std::ifstream reader(filename.data());
-            if (!reader) {
-                throw (std::invalid_argument(filename + " is invalid!"));
+            toolbox::mapped_file file(filename);
+            const char *begin = file.data();
+            const char *end = begin + file.size();
+
+            std::vector<std::string_view> fields;
+            const char *line_end = next_line(begin, end);
+            if (begin < end) {
+                if (split_fields(std::string_view(begin, line_end - begin), fields, delimiter)) {
+                    column_paste(string_vector(fields.begin(), fields.end()));
+                }
+                begin = line_end + 1;
             }
+            auto types = column_types(schema, begin, end, delimiter, sample_rows);
+            if (threads == 1 || width == 0)
+                parse_lines(begin, end, delimiter, types);
+            else parse_lines_parallel(begin, end, delimiter, types, threads);
+        }
 
-            std::string str_line;
-            string_vector value_str_vector;
-            if (getline(reader, str_line)) {
-                value_str_vector.clear();
-                if (splite_line(str_line, value_str_vector, delimiter)) {
-                    column_paste(value_str_vector);
-                }
+        //write into csv file
+
+        void to_csv(const char &delimiter = ',') const {
+            to_csv(dataframe_name, delimiter);
+        }
+
+        // rows are formatted into a large buffer which is written block by block,
+        // several threads format consecutive blocks when threads is not 1 (0 means all cores)
+        void to_csv(const std::string &filename, const char &delimiter = ',', unsigned int threads = 1) const {
+            write_csv(filename, column, std::vector<const column_array *>(matrix.begin(), matrix.end()), 0, length,
+                      delimiter, threads);
+        }
+
+        // write a binary snapshot: a header with the column names, types and row count,
+        // then the payload of every column aligned to 8 bytes followed by its validity bitmap when a cell is missing,
+        // numbers are kept in native byte order
+        void save_binary(const std::string &filename) const {
+            std::ofstream cout = std::ofstream(filename, std::ios::out | std::ios::trunc | std::ios::binary);
+            if (!cout) {
+                throw (std::invalid_argument(filename + " is invalid!"));
+            }
+            std::vector<unsigned long long int> types, sizes;
+            std::vector<std::string> cells(width);
+            for (unsigned long long int i = 0; i < width; ++i) {
+                matrix[i]->visit_buffer([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (std::is_same_v<V, user_variant>) {
+                        for (const auto &item : vec)
+                            toolbox::append_binary(cells[i], item);
+                        types.emplace_back(cell_column);
+                        sizes.emplace_back(cells[i].size());
+                    } else if constexpr (std::is_same_v<std::decay_t<decltype(vec)>, category_buffer>) {
+                        const auto &categories = vec.categories();
+                        types.emplace_back(category_column);
+                        sizes.emplace_back(sizeof(unsigned long long int) + strings_size(categories) +
+                                           vec.size() * sizeof(category_buffer::code_type));
+                    } else if constexpr (std::is_same_v<V, std::string>) {
+                        types.emplace_back(string_column);
+                        sizes.emplace_back(strings_size(vec));
+                    } else if constexpr (variant_contain<V, user_variant>::value) {
+                        types.emplace_back(user_variant(V()).index() + 1);
+                        sizes.emplace_back(vec.size() * sizeof(V));
+                    } else throw (std::invalid_argument("the type of column " + column[i] + " can not be saved"));
+                });
             }
 
-            while (getline(reader, str_line)) {
-                value_str_vector.clear();
-                if (splite_line(str_line, value_str_vector, delimiter)) {
-                    append_from_str(value_str_vector);
-                }
+            auto padded = [](unsigned long long int n) { return (n + 7) / 8 * 8; };
+            auto validity_size = [this](unsigned long long int i) {
+                return matrix[i]->validity().words().size() * sizeof(validity_bitmap::word_type);
+            };
+            unsigned long long int offset = sizeof(binary_magic) + 2 * sizeof(unsigned long long int);
+            for (const auto &item : column)
+                offset += 5 * sizeof(unsigned long long int) + padded(item.size());
+            std::string header(binary_magic, sizeof(binary_magic));
+            toolbox::append_binary(header, (unsigned long long int) width);
+            toolbox::append_binary(header, (unsigned long long int) length);
+            for (unsigned long long int i = 0; i < width; ++i) {
+                toolbox::append_binary(header, types[i]);
+                toolbox::append_binary(header, offset);
+                toolbox::append_binary(header, sizes[i]);
+                toolbox::append_binary(header, (unsigned long long int) validity_size(i));
+                toolbox::append_binary(header, (unsigned long long int) column[i].size());
+                header.append(column[i]);
+                header.resize(padded(header.size()), '\0');
+                offset += padded(sizes[i]) + validity_size(i);
+            }
+            cout.write(header.data(), header.size());
+
+            const char zeros[8] = {};
+            for (unsigned long long int i = 0; i < width; ++i) {
+                matrix[i]->visit_buffer([&](const auto &vec) {
+                    typedef typename std::decay_t<decltype(vec)>::value_type V;
+                    if constexpr (std::is_same_v<V, user_variant>) {
+                        cout.write(cells[i].data(), cells[i].size());
+                    } else if constexpr (std::is_same_v<std::decay_t<decltype(vec)>, category_buffer>) {
+                        unsigned long long int count = vec.categories().size();
+                        cout.write(reinterpret_cast<const char *>(&count), sizeof(count));
+                        write_strings(cout, vec.categories());
+                        cout.write(reinterpret_cast<const char *>(vec.get_codes().data()),
+                                   vec.size() * sizeof(category_buffer::code_type));
+                    } else if constexpr (std::is_same_v<V, std::string>) {
+                        write_strings(cout, vec);
+                    } else if constexpr (variant_contain<V, user_variant>::value) {
+                        cout.write(reinterpret_cast<const char *>(vec.data()), vec.size() * sizeof(V));
+                    }
+                });
+                cout.write(zeros, padded(sizes[i]) - sizes[i]);
+                cout.write(reinterpret_cast<const char *>(matrix[i]->validity().words().data()), validity_size(i));
             }
-            reader.close();
+            cout.close();
         }
 
-        //write into csv file
+        // read a binary snapshot written by save_binary, with mapped set the file stays mapped
+        // and numeric columns of dataframe<user_variant> view it directly until they are modified
+        void load_binary(const std::string &filename, bool mapped = false) {
+            auto file = std::make_shared<toolbox::mapped_file>(filename);
+            const char *data = file->data();
+            const unsigned long long int size = file->size();
+            auto invalid = [&filename]() {
+                return std::invalid_argument(filename + " is not a valid binary dataframe!");
+            };
+            unsigned long long int position = sizeof(binary_magic);
+            auto read = [&](unsigned long long int bytes) {
+                if (bytes > size || position > size - bytes)
+                    throw (invalid());
+                const char *result = data + position;
+                position += bytes;
+                return result;
+            };
+            auto read_number = [&]() {
+                unsigned long long int value;
+                std::memcpy(&value, read(sizeof(value)), sizeof(value));
+                return value;
+            };
+            // the first version of the format has no validity bitmaps
+            if (size < sizeof(binary_magic) || std::memcmp(data, binary_magic, sizeof(binary_magic) - 1) != 0 ||
+                (data[sizeof(binary_magic) - 1] != '1' && data[sizeof(binary_magic) - 1] != '2'))
+                throw (invalid());
+            const bool has_validity = data[sizeof(binary_magic) - 1] == '2';
+
+            unsigned long long int columns = read_number();
+            unsigned long long int rows = read_number();
+            string_vector names;
+            std::vector<unsigned long long int> types, offsets, sizes, validity_sizes;
+            for (unsigned long long int i = 0; i < columns; ++i) {
+                types.emplace_back(read_number());
+                offsets.emplace_back(read_number());
+                sizes.emplace_back(read_number());
+                validity_sizes.emplace_back(has_validity ? read_number() : 0);
+                unsigned long long int name_size = read_number();
+                if (name_size > size)
+                    throw (invalid());
+                const char *name = read((name_size + 7) / 8 * 8);
+                names.emplace_back(name, name_size);
+                unsigned long long int padded_size = (sizes[i] + 7) / 8 * 8;
+                if (offsets[i] > size || sizes[i] > size - offsets[i] ||
+                    (validity_sizes[i] != 0 && (padded_size > size - offsets[i] ||
+                                                validity_sizes[i] > size - offsets[i] - padded_size)))
+                    throw (invalid());
+            }
 
-        void to_csv(const char &delimiter = ',') const {
-            to_csv(dataframe_name, delimiter);
-        }
+            std::vector<storage_type> storages;
+            for (unsigned long long int i = 0; i < columns; ++i) {
+                const char *payload = data + offsets[i];
+                switch (types[i]) {
+                    case char_column:
+                        storages.emplace_back(load_numbers<char>(payload, sizes[i], rows, mapped, file, invalid));
+                        break;
+                    case int_column:
+                        storages.emplace_back(load_numbers<int>(payload, sizes[i], rows, mapped, file, invalid));
+                        break;
+                    case long_column:
+                        storages.emplace_back(load_numbers<long int>(payload, sizes[i], rows, mapped, file, invalid));
+                        break;
+                    case float_column:
+                        storages.emplace_back(load_numbers<float>(payload, sizes[i], rows, mapped, file, invalid));
+                        break;
+                    case double_column:
+                        storages.emplace_back(load_numbers<double>(payload, sizes[i], rows, mapped, file, invalid));
+                        break;
+                    case string_column:
+                        storages.emplace_back(load_string_column(payload, sizes[i], rows, invalid));
+                        break;
+                    case category_column:
+                        storages.emplace_back(load_categories(payload, sizes[i], rows, invalid));
+                        break;
+                    case cell_column:
+                        storages.emplace_back(load_cells(payload, sizes[i], rows, invalid));
+                        break;
+                    default:
+                        throw (invalid());
+                }
+            }
 
-        void to_csv(const std::string &filename, const char &delimiter = ',') const {
-            std::ofstream cout = std::ofstream(filename, std::ios::out | std::ios::trunc);
-            for (auto item = column.begin(); item < column.end() - 1; ++item) {
-                cout << *item << delimiter;
+            std::vector<validity_bitmap> validities;
+            for (unsigned long long int i = 0; i < columns; ++i) {
+                if (validity_sizes[i] == 0) {
+                    validities.emplace_back(rows);
+                    continue;
+                }
+                std::vector<validity_bitmap::word_type> words(validity_sizes[i] / sizeof(validity_bitmap::word_type));
+                if (validity_sizes[i] % sizeof(validity_bitmap::word_type) != 0 ||
+                    words.size() != (rows + validity_bitmap::word_bits - 1) / validity_bitmap::word_bits)
+                    throw (invalid());
+                std::memcpy(words.data(), data + offsets[i] + (sizes[i] + 7) / 8 * 8, validity_sizes[i]);
+                validities.emplace_back(std::move(words), rows);
             }
-            cout << column.back() << '\n';
-            for (unsigned long long int i = 0; i < row_num(); ++i) {
-                for (auto array = matrix.begin(); array < matrix.end() - 1; ++array) {
-                    std::visit(overloaded{
-                            [&cout](char value) { cout << value; },
-                            [&cout](int value) { cout << value; },
-                            [&cout](long int value) { cout << value; },
-                            [&cout](float value) { cout << value; },
-                            [&cout](double value) { cout << value; },
-                            [&cout](const std::string &value) { cout << value; },
-                    }, user_variant((**array)[i]));
-                    cout << delimiter;
-                }
-                std::visit(overloaded{
-                        [&cout](char value) { cout << value; },
-                        [&cout](int value) { cout << value; },
-                        [&cout](long int value) { cout << value; },
-                        [&cout](float value) { cout << value; },
-                        [&cout](double value) { cout << value; },
-                        [&cout](const std::string &value) { cout << value; },
-                }, user_variant((*matrix.back())[i]));
-                cout << '\n';
+
+            clear();
+            column_paste(names);
+            length = rows;
+            for (unsigned long long int i = 0; i < columns; ++i) {
+                *matrix[i]->array = std::move(storages[i]);
+                matrix[i]->valid = std::move(validities[i]);
             }
-            cout.close();
         }
 
 #ifdef libsvm
@@ -928,6 +5074,10 @@ namespace flame {
             cout << std::endl;
             for (unsigned long long int i = 0; i < dataframe.length; ++i) {
                 for (unsigned long long int j = 0; j < dataframe.width; ++j) {
+                    if (dataframe.matrix[j]->is_null(i)) {
+                        cout << "null" << separator;
+                        continue;
+                    }
                     std::visit(overloaded{
                             [&cout](char value) { cout << '\'' << value << '\''; },
                             [&cout](int value) { cout << std::setprecision(0) << value << 'i'; },
@@ -971,6 +5121,164 @@ namespace flame {
         }
 
     private:
+        typedef typename column_storage<T>::type storage_type;
+        static constexpr char binary_magic[8] = {'F', 'L', 'A', 'M', 'E', 'D', 'F', '2'};
+
+        // convert values of the physical type U into the storage of a column of dataframe<T>
+        template<typename U>
+        static storage_type store_values(std::vector<U> &&values) {
+            if constexpr (std::is_same_v<T, user_variant> || std::is_same_v<T, U>)
+                return storage_type(typename column_storage<T>::template buffer<U>(std::move(values)));
+            else if constexpr (std::is_constructible_v<T, U>)
+                return storage_type(std::vector<T>(values.begin(), values.end()));
+            else throw (std::invalid_argument("the column can not be converted into this dataframe"));
+        }
+
+        template<typename U, typename Invalid>
+        static storage_type load_numbers(const char *payload, unsigned long long int bytes, unsigned long long int rows,
+                                         bool mapped, const std::shared_ptr<toolbox::mapped_file> &file,
+                                         const Invalid &invalid) {
+            if (bytes != rows * sizeof(U) || rows > bytes)
+                throw (invalid());
+            if constexpr (std::is_same_v<T, user_variant>) {
+                if (mapped && reinterpret_cast<std::uintptr_t>(payload) % alignof(U) == 0)
+                    return storage_type(column_buffer<U>(reinterpret_cast<const U *>(payload), rows, file));
+            }
+            std::vector<U> values(rows);
+            std::memcpy(values.data(), payload, bytes);
+            return store_values(std::move(values));
+        }
+
+        // size of strings in a snapshot: the offsets of each string followed by the bytes of all strings
+        template<typename Strings>
+        static unsigned long long int strings_size(const Strings &strings) {
+            unsigned long long int bytes = (strings.size() + 1) * sizeof(unsigned long long int);
+            for (const auto &item : strings)
+                bytes += item.size();
+            return bytes;
+        }
+
+        // the offsets and the bytes of a string buffer are already laid out as in a snapshot
+        static unsigned long long int strings_size(const string_buffer &strings) {
+            return strings.get_offsets().size() * sizeof(string_buffer::offset_type) + strings.chars().size();
+        }
+
+        static void write_strings(std::ofstream &cout, const string_buffer &strings) {
+            cout.write(reinterpret_cast<const char *>(strings.get_offsets().data()),
+                       strings.get_offsets().size() * sizeof(string_buffer::offset_type));
+            cout.write(strings.chars().data(), strings.chars().size());
+        }
+
+        template<typename Strings>
+        static void write_strings(std::ofstream &cout, const Strings &strings) {
+            unsigned long long int position = 0;
+            cout.write(reinterpret_cast<const char *>(&position), sizeof(position));
+            for (const auto &item : strings) {
+                position += item.size();
+                cout.write(reinterpret_cast<const char *>(&position), sizeof(position));
+            }
+            for (const auto &item : strings)
+                cout.write(item.data(), item.size());
+        }
+
+        // read rows strings, bytes is set to the size they take
+        template<typename Strings, typename Invalid>
+        static Strings load_strings(const char *payload, unsigned long long int &bytes, unsigned long long int rows,
+                                    const Invalid &invalid) {
+            const unsigned long long int header = (rows + 1) * sizeof(unsigned long long int);
+            if (rows >= bytes || header > bytes)
+                throw (invalid());
+            Strings values;
+            unsigned long long int begin, end;
+            std::memcpy(&begin, payload, sizeof(begin));
+            if (begin != 0)
+                throw (invalid());
+            for (unsigned long long int i = 0; i < rows; ++i) {
+                std::memcpy(&end, payload + (i + 1) * sizeof(end), sizeof(end));
+                if (begin > end || end > bytes - header)
+                    throw (invalid());
+                values.emplace_back(payload + header + begin, end - begin);
+                begin = end;
+            }
+            bytes = header + begin;
+            return values;
+        }
+
+        template<typename Invalid>
+        static std::vector<std::string> load_strings(const char *payload, unsigned long long int bytes,
+                                                     unsigned long long int rows, const Invalid &invalid) {
+            return load_strings<std::vector<std::string>>(payload, bytes, rows, invalid);
+        }
+
+        // a column of strings, which dataframe<user_variant> copies into a string buffer in two blocks
+        template<typename Invalid>
+        static storage_type load_string_column(const char *payload, unsigned long long int bytes,
+                                               unsigned long long int rows, const Invalid &invalid) {
+            if constexpr (std::is_same_v<T, user_variant>) {
+                const unsigned long long int header = (rows + 1) * sizeof(string_buffer::offset_type);
+                if (rows >= bytes || header > bytes)
+                    throw (invalid());
+                std::vector<string_buffer::offset_type> offsets(rows + 1);
+                std::memcpy(offsets.data(), payload, header);
+                if (offsets.back() > bytes - header)
+                    throw (invalid());
+                std::vector<char> chars(payload + header, payload + header + offsets.back());
+                try {
+                    return storage_type(string_buffer(std::move(offsets), std::move(chars)));
+                } catch (std::invalid_argument &) {
+                    throw (invalid());
+                }
+            } else return store_values(load_strings(payload, bytes, rows, invalid));
+        }
+
+        // the number of categories, the categories as strings, then the code of every row
+        template<typename Invalid>
+        static storage_type load_categories(const char *payload, unsigned long long int bytes,
+                                            unsigned long long int rows, const Invalid &invalid) {
+            unsigned long long int count;
+            if (bytes < sizeof(count))
+                throw (invalid());
+            std::memcpy(&count, payload, sizeof(count));
+            unsigned long long int strings_bytes = bytes - sizeof(count);
+            auto categories = load_strings<std::deque<std::string>>(payload + sizeof(count), strings_bytes, count,
+                                                                    invalid);
+            const char *codes_payload = payload + sizeof(count) + strings_bytes;
+            if (bytes - sizeof(count) - strings_bytes != rows * sizeof(category_buffer::code_type) ||
+                rows > bytes)
+                throw (invalid());
+            std::vector<category_buffer::code_type> codes(rows);
+            std::memcpy(codes.data(), codes_payload, rows * sizeof(category_buffer::code_type));
+            try {
+                category_buffer values(std::move(categories), std::move(codes));
+                if constexpr (std::is_same_v<T, user_variant>) {
+                    return storage_type(std::move(values));
+                } else {
+                    std::vector<std::string> strings;
+                    for (unsigned long long int i = 0; i < values.size(); ++i)
+                        strings.emplace_back(values[i]);
+                    return store_values(std::move(strings));
+                }
+            } catch (std::invalid_argument &) {
+                throw (invalid());
+            }
+        }
+
+        template<typename Invalid>
+        static storage_type load_cells(const char *payload, unsigned long long int bytes, unsigned long long int rows,
+                                       const Invalid &invalid) {
+            std::vector<user_variant> values;
+            values.reserve(std::min(rows, bytes));
+            unsigned long long int position = 0;
+            for (unsigned long long int i = 0; i < rows; ++i) {
+                values.emplace_back();
+                if (!toolbox::read_binary(payload, bytes, position, values.back()))
+                    throw (invalid());
+            }
+            if constexpr (std::is_same_v<T, user_variant>)
+                return storage_type(std::move(values));
+            else throw (std::invalid_argument("the column can not be converted into this dataframe"));
+        }
+
         // clear all data, generate an empty dataframe
         void clear() {
             length = 0;
@@ -981,6 +5289,7 @@ namespace flame {
             matrix.clear();
             column.clear();
             index.clear();
+            indexes.clear();
         }
 
         //init the column
@@ -990,6 +5299,7 @@ namespace flame {
                 width = _column.size();
                 column.clear();
                 index.clear();
+                indexes.clear();
                 matrix.clear();
                 for (const auto &item : _column) {
                     column.emplace_back(item);
@@ -1030,14 +5340,10 @@ namespace flame {
         }
 
         //get one row data from index of row
-        [[maybe_unused]] row_array get_row(unsigned long long int i) {
-            if (i < length) {
-                row_array row_array;
-                for (auto &item : matrix) {
-                    row_array.push_back(&((*item)[i]));
-                }
-                return std::move(row_array);
-            } else {
+        [[maybe_unused]] row_view get_row(unsigned long long int i) {
+            if (i < length)
+                return row_view(this, i);
+            else {
                 std::stringstream ssTemp;
                 ssTemp << i;
                 throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
@@ -1045,106 +5351,730 @@ namespace flame {
         }
 
         //get one row data from index of row
-        [[maybe_unused]] const row_array &get_row(unsigned long long int i) const {
-            if (i < length) {
-                row_array row_array;
-                for (auto &item : matrix) {
-                    row_array.push_back(&((*item)[i]));
-                }
-                return std::move(row_array);
-            } else {
+        [[maybe_unused]] const_row_view get_row(unsigned long long int i) const {
+            if (i < length)
+                return const_row_view(this, i);
+            else {
                 std::stringstream ssTemp;
                 ssTemp << i;
                 throw (std::out_of_range("the index \'" + ssTemp.str() + "\' is out of range!"));
             }
         }
 
-        // separate strings by delimiter
-        bool splite_line(const std::string &str_line, string_vector &value_str_vector, const char &delimiter) {
-            unsigned long long begin_iter = 0;
-            unsigned long long end_iter;
-            bool flag = false;
-            std::string str_temp;
-            while ((end_iter = str_line.find_first_of(delimiter, begin_iter)) != std::string::npos) {
-                str_temp = str_line.substr(begin_iter, end_iter - begin_iter);
-                value_str_vector.emplace_back(str_temp);
-                begin_iter = end_iter + 1;
+        // write the rows [begin, end) of arrays under the header names as a csv file, see to_csv
+        static void write_csv(const std::string &filename, const string_vector &names,
+                              const std::vector<const column_array *> &arrays, unsigned long long int begin,
+                              unsigned long long int end, const char &delimiter, unsigned int threads) {
+            std::ofstream cout = std::ofstream(filename, std::ios::out | std::ios::trunc);
+            if (!cout) {
+                throw (std::invalid_argument(filename + " is invalid!"));
+            }
+            if (names.empty())
+                return;
+            std::string buffer;
+            for (auto item = names.begin(); item < names.end() - 1; ++item) {
+                buffer.append(*item);
+                buffer.push_back(delimiter);
+            }
+            buffer.append(names.back());
+            buffer.push_back('\n');
+            cout.write(buffer.data(), buffer.size());
+            buffer.clear();
+
+            const unsigned long long int block_rows = 1 << 16;
+            const unsigned long long int length = end - begin;
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            threads = (unsigned int) std::min<unsigned long long int>(threads, length / block_rows + 1);
+            if (threads == 1) {
+                for (unsigned long long int i = begin; i < end; i += block_rows) {
+                    format_rows(buffer, arrays, i, std::min(i + block_rows, end), delimiter);
+                    cout.write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            } else {
+                // each round formats one block per thread, an error of a thread is thrown here
+                std::vector<std::string> buffers(threads);
+                for (unsigned long long int first = begin; first < end; first += block_rows * threads) {
+                    toolbox::parallel_for(threads, threads, [&](unsigned long long int k) {
+                        unsigned long long int block_begin = std::min(first + block_rows * k, end);
+                        unsigned long long int block_end = std::min(block_begin + block_rows, end);
+                        buffers[k].clear();
+                        format_rows(buffers[k], arrays, block_begin, block_end, delimiter);
+                    });
+                    for (const auto &item : buffers)
+                        cout.write(item.data(), item.size());
+                }
+            }
+            cout.close();
+        }
+
+        // format rows in [begin, end) of arrays as csv lines
+        static void format_rows(std::string &buffer, const std::vector<const column_array *> &arrays,
+                                unsigned long long int begin, unsigned long long int end, const char &delimiter) {
+            for (unsigned long long int i = begin; i < end; ++i) {
+                for (const auto &array : arrays) {
+                    if (!array->is_null(i))
+                        array->visit_buffer([&buffer, i](const auto &vec) { toolbox::append_value(buffer, vec[i]); });
+                    buffer.push_back(delimiter);
+                }
+                buffer.back() = '\n';
+            }
+        }
+
+        // end of the line starting from begin
+        static const char *next_line(const char *begin, const char *end) {
+            auto line_end = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+            return line_end == nullptr ? end : line_end;
+        }
+
+        // separate a line by delimiter without copying, a line without delimiter is not a valid row
+        static bool split_fields(std::string_view line, std::vector<std::string_view> &fields, const char &delimiter) {
+            fields.clear();
+            if (line.find(delimiter) == std::string_view::npos)
+                return false;
+            unsigned long long int begin = 0;
+            unsigned long long int end;
+            while ((end = line.find(delimiter, begin)) != std::string_view::npos) {
+                fields.emplace_back(line.substr(begin, end - begin));
+                begin = end + 1;
             }
-            if ((begin_iter = str_line.find_last_of(delimiter, str_line.length() - 1)) != std::string::npos) {
-                str_temp = str_line.substr(begin_iter + 1, str_line.length() - begin_iter - 1);
-                value_str_vector.emplace_back(str_temp);
-                flag = true;
+            fields.emplace_back(line.substr(begin));
+            return true;
+        }
+
+        static void check_schema(const csv_schema &schema) {
+            for (const auto &item : schema) {
+                if (item.second == char_column)
+                    throw (std::invalid_argument("the type of column " + item.first + " can not be read from csv"));
             }
-            return flag;
         }
 
-        // append data from string vector
-        bool append_from_str(const string_vector &value_str_vector) {
-            if (value_str_vector.size() == column.size()) {
-                length++;
-                std::stringstream stream;
-                user_variant item;
-                for (unsigned long long int i = 0; i < value_str_vector.size(); ++i) {
-                    stream.clear();
-                    stream << value_str_vector[i];
-                    str_type type = get_string_type(value_str_vector[i]);
-                    if (type == int_type) {
-                        long int temp;
-                        stream >> temp;
-                        item = temp;
-                    } else if (type == float_type) {
-                        double temp;
-                        stream >> temp;
-                        item = temp;
-                    } else {
-                        std::string temp;
-                        stream >> temp;
-                        item = temp;
+        // type of each column: given by schema, or inferred from the first sample_rows valid rows between begin and end,
+        // integers give long_column, numbers with a float give double_column, words give string_column,
+        // words repeating on average four times or more give category_column,
+        // a column mixing numbers and words keeps cell_column and its cells are typed one by one
+        std::vector<column_type> column_types(const csv_schema &schema, const char *begin, const char *end,
+                                              const char &delimiter, unsigned long long int sample_rows) const {
+            check_schema(schema);
+            std::vector<column_type> types(width, cell_column);
+            std::vector<bool> inferred(width, true);
+            for (unsigned long long int i = 0; i < width; ++i) {
+                auto item = schema.find(column[i]);
+                if (item != schema.end()) {
+                    types[i] = item->second;
+                    inferred[i] = false;
+                }
+            }
+            if constexpr (!std::is_same_v<T, user_variant>)
+                return types;
+
+            std::vector<int> seen(width, 0);
+            std::vector<std::unordered_set<std::string_view>> words(width);
+            std::vector<std::string_view> fields;
+            unsigned long long int rows = 0;
+            while (begin < end && rows < sample_rows) {
+                const char *line_end = next_line(begin, end);
+                if (split_fields(std::string_view(begin, line_end - begin), fields, delimiter) &&
+                    fields.size() == width) {
+                    for (unsigned long long int i = 0; i < width; ++i) {
+                        if (toolbox::first_token(fields[i]).empty())
+                            continue;
+                        str_type type = get_string_type(fields[i]);
+                        seen[i] |= 1 << type;
+                        if (type == string_type)
+                            words[i].insert(toolbox::first_token(fields[i]));
                     }
+                    ++rows;
+                }
+                begin = line_end + 1;
+            }
+            for (unsigned long long int i = 0; i < width; ++i) {
+                if (!inferred[i] || seen[i] == 0)
+                    continue;
+                if (seen[i] == 1 << int_type)
+                    types[i] = long_column;
+                else if ((seen[i] & (1 << string_type)) == 0)
+                    types[i] = double_column;
+                else if (seen[i] == 1 << string_type)
+                    types[i] = words[i].size() * 4 <= rows ? category_column : string_column;
+            }
+            return types;
+        }
 
-                    std::visit(overloaded{
-                            [&](char value) {
-                                if (typeid(value) == typeid(T) || is_same_type<T, user_variant>())
-                                    matrix[i]->emplace_back(T(value));
-                            },
-                            [&](int value) {
-                                if (typeid(value) == typeid(T) || is_same_type<T, user_variant>())
-                                    matrix[i]->emplace_back(T(value));
-                            },
-                            [&](long int value) {
-                                if (is_numeric_type<T>() || is_same_type<T, user_variant>())
-                                    matrix[i]->emplace_back(T(value));
-                            },
-                            [&](float value) {
-                                if (typeid(value) == typeid(T) || is_same_type<T, user_variant>())
-                                    matrix[i]->emplace_back(T(value));
-                            },
-                            [&](double value) {
-                                if (is_numeric_type<T>() || is_same_type<T, user_variant>())
-                                    matrix[i]->emplace_back(T(value));
-                            },
-                            [&](const std::string &value) {
-                                if (typeid(value) == typeid(T) || is_same_type<T, user_variant>()) {
-                                    toolbox::user_stringstream uss;
-                                    uss << value;
-                                    T temp;
-                                    uss >> temp;
-                                    matrix[i]->emplace_back(temp);
-                                }
+        // append every valid row between begin and end
+        void parse_lines(const char *begin, const char *end, const char &delimiter,
+                         const std::vector<column_type> &types) {
+            std::vector<std::string_view> fields;
+            fields.reserve(width);
+            while (begin < end) {
+                const char *line_end = next_line(begin, end);
+                if (split_fields(std::string_view(begin, line_end - begin), fields, delimiter)) {
+                    append_fields(fields, types);
+                }
+                begin = line_end + 1;
+            }
+        }
 
-                            },
-                    }, item);
+        // split the rows at newline boundaries into one chunk per thread, then stitch the chunks in row order
+        void parse_lines_parallel(const char *begin, const char *end, const char &delimiter,
+                                  const std::vector<column_type> &types, unsigned int threads) {
+            if (begin >= end)
+                return;
+            if (threads == 0)
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            // small chunks are not worth a thread
+            const unsigned long long int min_chunk = 1 << 20;
+            threads = (unsigned int) std::min<unsigned long long int>(threads, (end - begin) / min_chunk + 1);
+            if (threads == 1) {
+                parse_lines(begin, end, delimiter, types);
+                return;
+            }
+
+            std::vector<const char *> bounds{begin};
+            for (unsigned int k = 1; k < threads; ++k) {
+                const char *bound = std::max(bounds.back(), begin + (end - begin) / threads * k);
+                if (bound < end)
+                    bound = next_line(bound, end) + 1;
+                bounds.emplace_back(std::min(bound, end));
+            }
+            bounds.emplace_back(end);
+
+            std::vector<dataframe> chunks;
+            for (unsigned int k = 0; k < threads; ++k)
+                chunks.emplace_back(column);
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> workers;
+            for (unsigned int k = 0; k < threads; ++k) {
+                workers.emplace_back([&, k]() {
+                    try {
+                        chunks[k].parse_lines(bounds[k], bounds[k + 1], delimiter, types);
+                    } catch (...) {
+                        errors[k] = std::current_exception();
+                    }
+                });
+            }
+            for (auto &worker : workers)
+                worker.join();
+            for (auto &error : errors)
+                if (error)
+                    std::rethrow_exception(error);
+
+            for (auto &chunk : chunks)
+                length += chunk.length;
+            for (unsigned long long int i = 0; i < width; ++i) {
+                matrix[i]->append(std::move(*chunks.front().matrix[i]));
+                matrix[i]->reserve(length);
+                for (unsigned int k = 1; k < threads; ++k)
+                    matrix[i]->append(*chunks[k].matrix[i]);
+            }
+        }
+
+        // position of column col, which must exist
+        [[nodiscard]] unsigned long long int position(const std::string &col) const {
+            auto item = index.find(col);
+            if (item == index.end())
+                throw (std::invalid_argument("the column \'" + col + "\' does not exist!"));
+            return item->second;
+        }
+
+        // append one row from fields of csv file
+        bool append_fields(const std::vector<std::string_view> &fields, const std::vector<column_type> &types) {
+            if (fields.size() == column.size()) {
+                length++;
+                for (unsigned long long int i = 0; i < fields.size(); ++i) {
+                    append_field(*matrix[i], fields[i], types[i]);
+                }
+                return true;
+            } else return false;
+        }
+
+        // append one row from the fields at positions, types has one entry per field
+        bool append_fields(const std::vector<std::string_view> &fields, const std::vector<column_type> &types,
+                           const std::vector<unsigned long long int> &positions) {
+            if (fields.size() == types.size()) {
+                length++;
+                for (unsigned long long int i = 0; i < positions.size(); ++i) {
+                    append_field(*matrix[i], fields[positions[i]], types[positions[i]]);
                 }
                 return true;
             } else return false;
         }
 
+        // append one field to a column of a fixed type, a field which is not of that type is typed by its content,
+        // an empty field is a missing value
+        static void append_field(column_array &array, std::string_view field, column_type type) {
+            if (toolbox::first_token(field).empty()) {
+                array.emplace_null();
+                return;
+            }
+            if constexpr (std::is_same_v<T, user_variant>) {
+                switch (type) {
+                    case int_column:
+                        if (append_exact<int>(array, field)) return;
+                        break;
+                    case long_column:
+                        if (append_exact<long int>(array, field)) return;
+                        break;
+                    case float_column:
+                        if (append_exact<float>(array, field)) return;
+                        break;
+                    case double_column:
+                        if (append_exact<double>(array, field)) return;
+                        break;
+                    case string_column:
+                        array.emplace_back_typed(toolbox::first_token(field));
+                        return;
+                    case category_column:
+                        if (array.type() != category_column)
+                            array.categorize();
+                        array.emplace_back_typed(toolbox::first_token(field));
+                        return;
+                    default:
+                        break;
+                }
+            }
+            append_field(array, field);
+        }
+
+        template<typename U>
+        static bool append_exact(column_array &array, std::string_view field) {
+            U value;
+            if (!toolbox::parse_exact(field, value))
+                return false;
+            array.emplace_back_typed(value);
+            return true;
+        }
+
+        // append one field to a column following the type of its content
+        static void append_field(column_array &array, std::string_view field) {
+            str_type type = get_string_type(field);
+            if (type == int_type) {
+                if constexpr (is_numeric_type<T>())
+                    array.emplace_back(T(toolbox::parse_integer(field)));
+                else if constexpr (std::is_same_v<T, user_variant>)
+                    array.emplace_back_typed(toolbox::parse_integer(field));
+            } else if (type == float_type) {
+                if constexpr (is_numeric_type<T>())
+                    array.emplace_back(T(toolbox::parse_floating(field)));
+                else if constexpr (std::is_same_v<T, user_variant>)
+                    array.emplace_back_typed(toolbox::parse_floating(field));
+            } else {
+                if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, user_variant>)
+                    array.emplace_back_typed(toolbox::first_token(field));
+            }
+        }
+
         std::string dataframe_name;
         std::vector<std::string> column;
         std::vector<column_array *> matrix;
         unsigned long long int width;
         unsigned long long int length;
         std::unordered_map<std::string, unsigned long long int> index;
+        // shared by the copies of the frame like the column buffers, a const lookup may rebuild a stale one
+        mutable std::unordered_map<std::string, std::shared_ptr<column_index>> indexes;
+        mutable std::mutex index_mutex;
+    };
+
+    // read a csv file batch by batch, only one block of the file and one batch are kept in memory
+    template<typename T = user_variant>
+    class csv_batch_reader {
+    public:
+        explicit csv_batch_reader(const std::string &filename, unsigned long long int batch_size = 65536,
+                                  const char &delimiter = ',', unsigned long long int block_size = 1 << 20,
+                                  const csv_schema &schema = {}, unsigned long long int sample_rows = 1000) :
+                filename(filename), reader(filename, std::ios::in | std::ios::binary),
+                buffer(std::max<unsigned long long int>(block_size, 1)),
+                batch_size(std::max<unsigned long long int>(batch_size, 1)), delimiter(delimiter) {
+            if (!reader) {
+                throw (std::invalid_argument(filename + " is invalid!"));
+            }
+            std::string_view line;
+            if (next_line(line)) {
+                if (dataframe<T>::split_fields(line, fields, delimiter))
+                    column.assign(fields.begin(), fields.end());
+            }
+            // the column types are inferred from the same sample rows as read_csv, which are kept in the buffer
+            while (!exhausted && sample_size() < sample_rows)
+                fill();
+            types = dataframe<T>(column).column_types(schema, buffer.data() + begin, buffer.data() + filled,
+                                                      delimiter, sample_rows);
+            select(column);
+        }
+
+        // read only the given columns into the batches, the other fields of a row are not parsed
+        void select(const std::vector<std::string> &names) {
+            std::vector<unsigned long long int> found;
+            for (const auto &name : names)
+                found.emplace_back(position(name));
+            positions = std::move(found);
+            selected = names;
+        }
+
+        // keep only the rows where predicate is true for the value of column name, the field is parsed and
+        // tested before the other fields of the row, rows missing that value are skipped
+        void where(const std::string &name, std::function<bool(const T &)> predicate) {
+            filters.emplace_back(position(name), std::move(predicate));
+            probes.emplace_back();
+        }
+
+        // read the next rows into batch, whose buffers are reused, return false when the file is exhausted
+        bool next(dataframe<T> &batch) {
+            if (batch.get_column_str() != selected || batch.column_num() != selected.size())
+                batch = dataframe<T>(selected, filename);
+            else batch.clear_rows();
+            std::string_view line;
+            while (batch.row_num() < batch_size && next_line(line)) {
+                if (dataframe<T>::split_fields(line, fields, delimiter) && fields.size() == column.size() &&
+                    accept(fields))
+                    batch.append_fields(fields, types, positions);
+            }
+            return !batch.empty();
+        }
+
+        // call function with every batch of the file
+        template<typename Function>
+        void for_each(Function &&function) {
+            dataframe<T> batch;
+            while (next(batch)) {
+                function(batch);
+            }
+        }
+
+        // get string vector of columns
+        const std::vector<std::string> &get_column_str() const {
+            return column;
+        }
+
+    private:
+        unsigned long long int position(const std::string &name) const {
+            auto item = std::find(column.begin(), column.end(), name);
+            if (item == column.end())
+                throw (std::invalid_argument("the column \'" + name + "\' does not exist!"));
+            return item - column.begin();
+        }
+
+        // whether a row passes every filter
+        bool accept(const std::vector<std::string_view> &row) {
+            for (unsigned long long int k = 0; k < filters.size(); ++k) {
+                auto &probe = probes[k];
+                probe.clear();
+                dataframe<T>::append_field(probe, row[filters[k].first], types[filters[k].first]);
+                if (probe.is_null(0) || !filters[k].second(probe.get(0)))
+                    return false;
+            }
+            return true;
+        }
+
+        // get the next line from the block buffer, the buffer is refilled or grown when the line is not complete
+        bool next_line(std::string_view &line) {
+            while (true) {
+                auto line_end = static_cast<const char *>(
+                        std::memchr(buffer.data() + begin, '\n', filled - begin));
+                if (line_end != nullptr) {
+                    line = std::string_view(buffer.data() + begin, line_end - buffer.data() - begin);
+                    begin = line_end - buffer.data() + 1;
+                    return true;
+                }
+                if (exhausted) {
+                    if (begin == filled)
+                        return false;
+                    line = std::string_view(buffer.data() + begin, filled - begin);
+                    begin = filled;
+                    return true;
+                }
+                fill();
+            }
+        }
+
+        // read more of the file after the unread part of the buffer, which is grown when it is full
+        void fill() {
+            std::memmove(buffer.data(), buffer.data() + begin, filled - begin);
+            filled -= begin;
+            begin = 0;
+            if (filled == buffer.size())
+                buffer.resize(buffer.size() * 2);
+            reader.read(buffer.data() + filled, buffer.size() - filled);
+            filled += reader.gcount();
+            exhausted = !reader;
+        }
+
+        // number of valid rows in the complete lines of the buffer
+        unsigned long long int sample_size() {
+            unsigned long long int rows = 0;
+            const char *line = buffer.data() + begin;
+            const char *end = buffer.data() + filled;
+            const char *line_end;
+            while ((line_end = static_cast<const char *>(std::memchr(line, '\n', end - line))) != nullptr) {
+                if (dataframe<T>::split_fields(std::string_view(line, line_end - line), fields, delimiter) &&
+                    fields.size() == column.size())
+                    ++rows;
+                line = line_end + 1;
+            }
+            return rows;
+        }
+
+        std::string filename;
+        std::ifstream reader;
+        std::vector<char> buffer;
+        unsigned long long int begin = 0;
+        unsigned long long int filled = 0;
+        bool exhausted = false;
+        unsigned long long int batch_size;
+        char delimiter;
+        std::vector<std::string> column;
+        std::vector<column_type> types;
+        std::vector<std::string_view> fields;
+        std::vector<std::string> selected;
+        std::vector<unsigned long long int> positions;
+        std::vector<std::pair<unsigned long long int, std::function<bool(const T &)>>> filters;
+        std::vector<typename dataframe<T>::column_array> probes;
+    };
+
+    // a lazy query over a csv file, filter, select and derive only record steps, collect and aggregate optimize
+    // the plan and run it in a single pass over batches of rows without building any whole intermediate:
+    // filters on columns of the file are pushed into the scan and tested before the rest of a row is parsed,
+    // only the columns used by later steps are read and derived columns which are never used are dropped
+    template<typename T = user_variant>
+    class query {
+    public:
+        typedef std::function<bool(const T &)> predicate_type;
+        typedef std::function<T(const std::vector<T> &)> derive_type;
+
+        explicit query(std::string filename, unsigned long long int batch_size = 65536, const char &delimiter = ',',
+                       csv_schema schema = {}) :
+                filename(std::move(filename)), batch_size(batch_size), delimiter(delimiter),
+                schema(std::move(schema)) {
+            header = csv_batch_reader<T>(this->filename, batch_size, delimiter, 1 << 20, this->schema).get_column_str();
+        }
+
+        // keep the rows where predicate is true for the value of col, rows missing col are removed
+        query &filter(const std::string &col, predicate_type predicate) {
+            steps.push_back({filter_step, col, {}, std::move(predicate), nullptr});
+            return *this;
+        }
+
+        // keep only the given columns, in this order
+        query &select(const std::vector<std::string> &cols) {
+            steps.push_back({select_step, "", cols, nullptr, nullptr});
+            return *this;
+        }
+
+        // add column col, function gets the values of inputs in one row, col is missing where one of them is
+        query &derive(const std::string &col, const std::vector<std::string> &inputs, derive_type function) {
+            steps.push_back({derive_step, col, inputs, nullptr, std::move(function)});
+            return *this;
+        }
+
+        // the optimized plan, one line per step, for collect or for aggregate when aggregates are given
+        [[nodiscard]] std::string explain(const std::vector<std::pair<std::string, aggregate_type>> &aggregates = {})
+        const {
+            auto plan = optimize(aggregates);
+            auto list = [](const std::vector<std::string> &names) {
+                std::string result = "[";
+                for (unsigned long long int i = 0; i < names.size(); ++i)
+                    result += (i == 0 ? "" : ", ") + names[i];
+                return result + "]";
+            };
+            std::vector<std::string> pushed;
+            for (const auto *item : plan.pushed)
+                pushed.emplace_back(item->name);
+            std::string result = "scan " + filename + " " + list(plan.scan) + " where " + list(pushed) + "\n";
+            for (const auto *item : plan.fused) {
+                if (item->kind == derive_step)
+                    result += "derive " + item->name + " from " + list(item->inputs) + "\n";
+                else result += "filter " + item->name + "\n";
+            }
+            if (aggregates.empty())
+                return result + "output " + list(plan.output) + "\n";
+            std::vector<std::string> outputs;
+            for (const auto &item : aggregates)
+                outputs.emplace_back(aggregate_name(item.first, item.second));
+            return result + "aggregate " + list(outputs) + "\n";
+        }
+
+        // run the query and gather its rows
+        [[nodiscard]] dataframe<T> collect() const {
+            auto plan = optimize({});
+            dataframe<T> result(plan.output, filename);
+            run(plan, [&plan, &result](dataframe<T> &batch) {
+                for (unsigned long long int i = 0; i < plan.output.size(); ++i)
+                    result.matrix[i]->append(batch[plan.output[i]]);
+                result.length += batch.row_num();
+            });
+            return result;
+        }
+
+        // run the query and reduce columns of its rows, one column named col_aggregate per pair in a single row,
+        // the batches are reduced as they are read
+        [[nodiscard]] dataframe<user_variant>
+        aggregate(const std::vector<std::pair<std::string, aggregate_type>> &aggregates) const {
+            auto plan = optimize(aggregates);
+            std::vector<toolbox::moments> statistics(aggregates.size());
+            std::vector<double> sums(aggregates.size(), 0);
+            run(plan, [&](dataframe<T> &batch) {
+                for (unsigned long long int i = 0; i < aggregates.size(); ++i) {
+                    const auto &array = batch[aggregates[i].first];
+                    statistics[i].merge(array.statistics(0, array.size()));
+                    sums[i] += array.sum();
+                }
+            });
+            std::vector<std::string> names;
+            std::vector<user_variant> row;
+            for (unsigned long long int i = 0; i < aggregates.size(); ++i) {
+                names.emplace_back(aggregate_name(aggregates[i].first, aggregates[i].second));
+                row.emplace_back(aggregate_value(statistics[i], sums[i], aggregates[i].second));
+            }
+            dataframe<user_variant> result(names, filename);
+            result.append(std::move(row));
+            return result;
+        }
+
+    private:
+        enum step_kind {
+            filter_step,
+            select_step,
+            derive_step
+        };
+
+        struct step {
+            step_kind kind;
+            std::string name;
+            std::vector<std::string> inputs;
+            predicate_type predicate;
+            derive_type function;
+        };
+
+        struct plan_type {
+            // columns read from the file, in the order of the file
+            std::vector<std::string> scan;
+            // filters tested by the scan
+            std::vector<const step *> pushed;
+            // derives and filters on derived columns, run one after another on each batch
+            std::vector<const step *> fused;
+            std::vector<std::string> output;
+        };
+
+        // check the names used by the steps, push the filters on columns of the file into the scan,
+        // then walk back from the outputs to keep only the columns and derives they need
+        plan_type optimize(const std::vector<std::pair<std::string, aggregate_type>> &aggregates) const {
+            std::vector<std::string> available = header;
+            std::unordered_set<std::string> derived;
+            auto check = [&available](const std::string &col) {
+                if (std::find(available.begin(), available.end(), col) == available.end())
+                    throw (std::invalid_argument("the column \'" + col + "\' does not exist!"));
+            };
+            plan_type plan;
+            std::vector<const step *> rest;
+            for (const auto &item : steps) {
+                switch (item.kind) {
+                    case filter_step:
+                        check(item.name);
+                        if (derived.count(item.name) == 0)
+                            plan.pushed.emplace_back(&item);
+                        else rest.emplace_back(&item);
+                        break;
+                    case select_step: {
+                        std::unordered_set<std::string> kept;
+                        for (const auto &col : item.inputs) {
+                            check(col);
+                            kept.emplace(col);
+                        }
+                        for (auto i = derived.begin(); i != derived.end();)
+                            i = kept.count(*i) == 0 ? derived.erase(i) : std::next(i);
+                        available = item.inputs;
+                        break;
+                    }
+                    case derive_step:
+                        for (const auto &col : item.inputs)
+                            check(col);
+                        if (std::find(available.begin(), available.end(), item.name) != available.end())
+                            throw (std::invalid_argument("the column \'" + item.name + "\' already exists!"));
+                        available.emplace_back(item.name);
+                        derived.emplace(item.name);
+                        rest.emplace_back(&item);
+                        break;
+                }
+            }
+            if (aggregates.empty()) {
+                plan.output = available;
+            } else {
+                for (const auto &item : aggregates) {
+                    check(item.first);
+                    if (std::find(plan.output.begin(), plan.output.end(), item.first) == plan.output.end())
+                        plan.output.emplace_back(item.first);
+                }
+            }
+            std::unordered_set<std::string> needed(plan.output.begin(), plan.output.end());
+            for (auto i = rest.rbegin(); i != rest.rend(); ++i) {
+                if ((*i)->kind == derive_step) {
+                    if (needed.erase((*i)->name) == 0)
+                        continue;
+                    needed.insert((*i)->inputs.begin(), (*i)->inputs.end());
+                } else needed.emplace((*i)->name);
+                plan.fused.emplace_back(*i);
+            }
+            std::reverse(plan.fused.begin(), plan.fused.end());
+            for (const auto &col : header) {
+                if (needed.count(col) != 0)
+                    plan.scan.emplace_back(col);
+            }
+            // one column is still read to count the rows
+            if (plan.scan.empty() && !header.empty())
+                plan.scan.emplace_back(header.front());
+            return plan;
+        }
+
+        // read the file batch by batch, run the fused steps on each batch and hand it to consume
+        template<typename Consume>
+        void run(const plan_type &plan, Consume &&consume) const {
+            csv_batch_reader<T> reader(filename, batch_size, delimiter, 1 << 20, schema);
+            reader.select(plan.scan);
+            for (const auto *item : plan.pushed)
+                reader.where(item->name, item->predicate);
+            dataframe<T> batch;
+            std::vector<T> values;
+            std::vector<const typename dataframe<T>::column_array *> inputs;
+            while (reader.next(batch)) {
+                for (const auto *item : plan.fused) {
+                    if (item->kind == filter_step) {
+                        batch.filter(batch[item->name].mask(item->predicate));
+                        continue;
+                    }
+                    inputs.clear();
+                    for (const auto &col : item->inputs)
+                        inputs.emplace_back(&batch[col]);
+                    values.resize(inputs.size());
+                    typename dataframe<T>::column_array array;
+                    array.reserve(batch.row_num());
+                    for (unsigned long long int i = 0; i < batch.row_num(); ++i) {
+                        bool missing = false;
+                        for (unsigned long long int k = 0; k < inputs.size() && !missing; ++k) {
+                            missing = inputs[k]->is_null(i);
+                            if (!missing)
+                                values[k] = inputs[k]->get(i);
+                        }
+                        if (missing)
+                            array.emplace_null();
+                        else array.emplace_back(item->function(values));
+                    }
+                    batch.insert(item->name, std::move(array));
+                }
+                consume(batch);
+                // the derived columns are removed so that the reader reuses the buffers of the batch
+                for (const auto *item : plan.fused) {
+                    if (item->kind == derive_step)
+                        batch.remove(item->name);
+                }
+            }
+        }
+
+        std::string filename;
+        unsigned long long int batch_size;
+        char delimiter;
+        csv_schema schema;
+        std::vector<std::string> header;
+        std::vector<step> steps;
     };
 
         namespace toolbox {
@@ -1179,11 +6109,77 @@ namespace flame {
                     return result;
                 }
 
+            protected:
+                // moments of every column over all the rows fitted so far
+                std::vector<moments> statistics;
+
+                void check_width(const typename dataframe<T>::frame_view &dataset) const {
+                    if (dataset.column_num() > scaler_array.size())
+                        throw (std::invalid_argument("the scaler has fewer columns than the dataframe"));
+                }
+
+                // parameters of one column from its moments
+                [[nodiscard]] virtual std::pair<double, double> parameter([[maybe_unused]] const moments &stats) const {
+                    return {0, 1};
+                }
+
+                // moments of every column of dataset, the columns are split into chunks of rows
+                // which are read by up to threads threads (0 means all cores) and merged in row order
+                static std::vector<moments> compute(const typename dataframe<T>::frame_view &dataset,
+                                                    unsigned int threads) {
+                    const unsigned long long int width = dataset.column_num();
+                    const unsigned long long int length = dataset.row_num();
+                    if (threads == 0)
+                        threads = std::max(1u, std::thread::hardware_concurrency());
+                    // small chunks are not worth a thread
+                    const unsigned long long int min_chunk = 1 << 16;
+                    const unsigned long long int chunks =
+                            std::max<unsigned long long int>(1, std::min<unsigned long long int>(threads,
+                                                                                                length / min_chunk));
+                    const unsigned long long int chunk_size = (length + chunks - 1) / chunks;
+                    std::vector<moments> parts(width * chunks);
+                    auto work = [&](unsigned long long int task) {
+                        unsigned long long int i = task / chunks, begin = task % chunks * chunk_size;
+                        parts[task] = dataset(i).statistics(dataset.offset() + begin,
+                                                            dataset.offset() + std::min(length, begin + chunk_size));
+                    };
+                    const unsigned long long int tasks = parts.size();
+                    parallel_for(tasks, threads, work);
+                    std::vector<moments> result(width);
+                    for (unsigned long long int task = 0; task < tasks; ++task)
+                        result[task / chunks].merge(parts[task]);
+                    return result;
+                }
+
             public:
                 std::vector<std::pair<double, double>> scaler_array;
 
                 explicit scaler() : scaler_array({}) {}
 
+                virtual ~scaler() = default;
+
+                // fit the scaler on dataset alone, forgetting the rows fitted before, a view of a dataframe
+                // fits its rows and columns only
+                void fit(const typename dataframe<T>::frame_view &dataset, unsigned int threads = 1) {
+                    statistics.clear();
+                    partial_fit(dataset, threads);
+                }
+
+                // fold one batch into the rows fitted so far and update scaler_array, batches of a stream or
+                // shards of a dataset give the same result as fitting all of their rows at once
+                void partial_fit(const typename dataframe<T>::frame_view &batch, unsigned int threads = 1) {
+                    auto stats = compute(batch, threads);
+                    if (statistics.empty()) {
+                        statistics = std::move(stats);
+                    } else if (stats.size() == statistics.size()) {
+                        for (unsigned long long int i = 0; i < stats.size(); ++i)
+                            statistics[i].merge(stats[i]);
+                    } else throw (std::invalid_argument("the batch does not have the columns fitted before"));
+                    scaler_array.clear();
+                    for (const auto &item : statistics)
+                        scaler_array.emplace_back(parameter(item));
+                }
+
                 explicit scaler(std::vector<std::pair<double, double>> _scaler_array) : scaler_array(
                         std::move(_scaler_array)) {}
 
@@ -1202,20 +6198,39 @@ namespace flame {
                     std::cout << "{" << scaler_array.back().first << "," << scaler_array.back().second << "}";
                 }
 
-                void transform(dataframe<T> &dataset) {
-                    for (unsigned long long int i = 0; i < dataset.column_num(); ++i) {
-                        for (unsigned long long int j = 0; j < dataset.row_num(); ++j) {
-                            dataset(i)[j] = transform(dataset(i)[j], scaler_array[i]);
-                        }
-                    }
+                // scale every number in place, one column per task on up to threads threads (0 means all cores)
+                void transform(dataframe<T> &dataset, unsigned int threads = 1) {
+                    check_width(dataset);
+                    parallel_for(dataset.column_num(), threads, [&](unsigned long long int i) {
+                        const auto param = scaler_array[i];
+                        dataset(i).transform_numbers([param](double value) {
+                            return (value - param.first) / param.second;
+                        });
+                    });
                     dataset.set_scaler_flag(true);
                 }
 
-                dataframe<T> transform_copy(const dataframe<T> &dataset) {
-                    dataframe<T> dataset_copy(dataset);
-                    transform(dataset_copy);
+                // scaled columns are written straight into new buffers, the source is not copied first
+                dataframe<T> transform_copy(const dataframe<T> &dataset, unsigned int threads = 1) {
+                    check_width(dataset);
+                    auto dataset_copy = dataset.transform_columns([this](unsigned long long int i,
+                                                                         const auto &array) {
+                        const auto param = scaler_array[i];
+                        return array.transformed([param](double value) {
+                            return (value - param.first) / param.second;
+                        });
+                    }, threads);
                     dataset_copy.set_scaler_flag(true);
-                    return std::move(dataset_copy);
+                    return dataset_copy;
+                }
+
+                // the rows and columns of a view scaled into a new dataframe, only those rows are copied
+                dataframe<T> transform_copy(const typename dataframe<T>::frame_view &dataset,
+                                            unsigned int threads = 1) {
+                    check_width(dataset);
+                    auto dataset_copy = dataset.materialize();
+                    transform(dataset_copy, threads);
+                    return dataset_copy;
                 }
 
                 void transform(std::vector<T> &data) {
@@ -1256,58 +6271,23 @@ namespace flame {
 
             template<typename T = double>
             class min_max_scaler : public scaler<T> {
+            protected:
+                [[nodiscard]] std::pair<double, double> parameter(const moments &stats) const override {
+                    if (stats.count == 0)
+                        return {0, 1};
+                    double second_value = stats.max - stats.min;
+                    if (std::abs(second_value - (long int) (second_value)) < 1e-3)
+                        second_value = 1;
+                    return {stats.min, second_value};
+                }
+
             public:
-                explicit min_max_scaler(const dataframe<T> &dataset) {
-                    scaler<T>::scaler_array.clear();
-                    for (const auto &array : dataset) {
-                        double min_value = 0;
-                        double max_value = 0;
-                        std::visit(overloaded{
-                                [&min_value](char value) { min_value = value; },
-                                [&min_value](int value) { min_value = value; },
-                                [&min_value](long int value) { min_value = value; },
-                                [&min_value](float value) { min_value = value; },
-                                [&min_value](double value) { min_value = value; },
-                                [&min_value](const std::string &value) { min_value = 0; },
-                        }, user_variant(*array->begin()));
+                explicit min_max_scaler(const dataframe<T> &dataset, unsigned int threads = 1) {
+                    scaler<T>::fit(dataset, threads);
+                }
 
-                        std::visit(overloaded{
-                                [&max_value](char value) { max_value = value; },
-                                [&max_value](int value) { max_value = value; },
-                                [&max_value](long int value) { max_value = value; },
-                                [&max_value](float value) { max_value = value; },
-                                [&max_value](double value) { max_value = value; },
-                                [&max_value](const std::string &value) { max_value = 0; },
-                        }, user_variant(*array->begin()));
-
-                        for (const auto &item : *array) {
-                            if (item < min_value) {
-                                // min_value = item;
-                                std::visit(overloaded{
-                                        [&min_value](char value) { min_value = value; },
-                                        [&min_value](int value) { min_value = value; },
-                                        [&min_value](long int value) { min_value = value; },
-                                        [&min_value](float value) { min_value = value; },
-                                        [&min_value](double value) { min_value = value; },
-                                        [&min_value](const std::string &value) { min_value = 0; },
-                                }, user_variant(item));
-                            } else if (item > max_value) {
-                                // max_value = item;
-                                std::visit(overloaded{
-                                        [&max_value](char value) { max_value = value; },
-                                        [&max_value](int value) { max_value = value; },
-                                        [&max_value](long int value) { max_value = value; },
-                                        [&max_value](float value) { max_value = value; },
-                                        [&max_value](double value) { max_value = value; },
-                                        [&max_value](const std::string &value) { max_value = 0; },
-                                }, user_variant(item));
-                            }
-                        }
-                        double second_value = max_value - min_value;
-                        if (std::abs(second_value - (long int) (second_value)) < 1e-3)
-                            second_value = 1;
-                        scaler<T>::scaler_array.emplace_back(std::pair<double, double>{min_value, second_value});
-                    }
+                explicit min_max_scaler(const typename dataframe<T>::frame_view &dataset, unsigned int threads = 1) {
+                    scaler<T>::fit(dataset, threads);
                 }
 
                 explicit min_max_scaler(const std::vector<std::pair<double, double>> &_scaler_array) : scaler<T>(
@@ -1323,40 +6303,24 @@ namespace flame {
 
             template<typename T = double>
             class standard_scaler : public scaler<T> {
+            protected:
+                // words count as 0 in the mean but not in the deviations, as they always have
+                [[nodiscard]] std::pair<double, double> parameter(const moments &stats) const override {
+                    double mean = stats.count * stats.mean / stats.cells;
+                    double deviation = stats.mean - mean;
+                    double sum = (stats.m2 + stats.count * deviation * deviation) / double(stats.cells - 1);
+                    if (std::abs(sum - (long int) (sum)) < 1e-3)
+                        sum = 1;
+                    return {mean, std::sqrt(sum)};
+                }
+
             public:
-                explicit standard_scaler(const dataframe<T> &dataset) {
-                    scaler<T>::scaler_array.clear();
-                    for (const auto &array : dataset) {
-                        double sum = 0;
-                        for (const auto &item : *array) {
-                            // sum += item;
-                            std::visit(overloaded{
-                                    [&sum](char value) { sum += value; },
-                                    [&sum](int value) { sum += value; },
-                                    [&sum](long int value) { sum += value; },
-                                    [&sum](float value) { sum += value; },
-                                    [&sum](double value) { sum += value; },
-                                    [&sum](const std::string &value) { sum += 0; },
-                            }, user_variant(item));
-                        }
-                        double mean = sum / array->size();
-                        sum = 0;
-                        for (const auto &item : *array) {
-                            // sum += std::pow((item - mean), 2);
-                            std::visit(overloaded{
-                                    [&sum, &mean](char value) { sum += std::pow((value - mean), 2); },
-                                    [&sum, &mean](int value) { sum += std::pow((value - mean), 2); },
-                                    [&sum, &mean](long int value) { sum += std::pow((value - mean), 2); },
-                                    [&sum, &mean](float value) { sum += std::pow((value - mean), 2); },
-                                    [&sum, &mean](double value) { sum += std::pow((value - mean), 2); },
-                                    [&sum, &mean](const std::string &value) { sum += 0; },
-                            }, user_variant(item));
-                        }
-                        sum /= double(array->size() - 1);
-                        if (std::abs(sum - (long int) (sum)) < 1e-3)
-                            sum = 1;
-                        scaler<T>::scaler_array.emplace_back(std::pair<double, double>{mean, std::sqrt(sum)});
-                    }
+                explicit standard_scaler(const dataframe<T> &dataset, unsigned int threads = 1) {
+                    scaler<T>::fit(dataset, threads);
+                }
+
+                explicit standard_scaler(const typename dataframe<T>::frame_view &dataset, unsigned int threads = 1) {
+                    scaler<T>::fit(dataset, threads);
                 }
 
                 explicit standard_scaler(const std::vector<std::pair<double, double>> &_scaler_array) : scaler<T>(
@@ -0,0 +1,16 @@
+#ifndef DATAFRAME_TESTS_CHECK_H
+#define DATAFRAME_TESTS_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+// stop the test at the first condition which does not hold, assert is not used as it is gone with NDEBUG
+#define CHECK(condition)                                                                \
+    do {                                                                                \
+        if (!(condition)) {                                                             \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl; \
+            std::exit(1);                                                               \
+        }                                                                               \
+    } while (false)
+
+#endif //DATAFRAME_TESTS_CHECK_H
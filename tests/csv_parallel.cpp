@@ -0,0 +1,52 @@
+#include "dataframe.hpp"
+#include "check.hpp"
+#include <random>
+
+using namespace flame;
+
+// the frames hold the same columns of the same layout and the same cells in the same rows
+static void check_same(const dataframe<> &a, const dataframe<> &b) {
+    CHECK(a.column_num() == b.column_num());
+    CHECK(a.row_num() == b.row_num());
+    for (unsigned long long int j = 0; j < a.column_num(); ++j) {
+        CHECK(a(j).type() == b(j).type());
+        for (unsigned long long int i = 0; i < a.row_num(); ++i)
+            CHECK(a(j).get(i) == b(j).get(i));
+    }
+}
+
+int main() {
+    // several megabytes, so that the file is split into one chunk per thread
+    std::mt19937 random(3);
+    for (const std::string newline : {"\n", "\r\n"}) {
+        {
+            std::ofstream file("parallel.csv", std::ios::binary);
+            file << "id,price,name,mixed" << newline;
+            for (int i = 0; i < 200000; ++i) {
+                file << i << "," << (random() % 100000) / 8.0 << ",name" << random() % 1000 << ",";
+                if (random() % 3 == 0)
+                    file << "word" << i;
+                else file << random() % 100;
+                file << newline;
+            }
+            // the last line has no newline
+            file << "200000,1.5,last,7";
+        }
+        dataframe<> serial("parallel.csv", ',', 1);
+        CHECK(serial.row_num() == 200001);
+        for (unsigned int threads : {2u, 3u, 8u, 0u}) {
+            dataframe<> parallel("parallel.csv", ',', threads);
+            check_same(serial, parallel);
+        }
+    }
+
+    // a file smaller than one chunk per thread is read by fewer threads
+    {
+        std::ofstream file("small.csv", std::ios::binary);
+        file << "a,b\n1,x\n2,y\n";
+    }
+    dataframe<> small("small.csv", ',', 8);
+    check_same(dataframe<>("small.csv", ',', 1), small);
+    CHECK(small.row_num() == 2);
+    return 0;
+}
@@ -0,0 +1,115 @@
+// group_by(keys).agg(...) against a nested loop over the rows, with one and several threads
+
+#include <cmath>
+#include <fstream>
+#include <optional>
+#include <random>
+#include "dataframe.hpp"
+#include "check.hpp"
+
+using namespace flame;
+
+struct row {
+    std::string city;
+    std::optional<long int> code;
+    std::optional<double> v;
+    std::optional<double> w;
+};
+
+static bool close(double a, double b) {
+    if (std::isnan(a) || std::isnan(b))
+        return std::isnan(a) && std::isnan(b);
+    return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b));
+}
+
+int main() {
+    // enough rows for several chunks, a missing value is an empty field
+    std::vector<row> rows;
+    std::mt19937_64 random(7);
+    const char *cities[] = {"paris", "lyon", "nice", "lille", "brest"};
+    for (unsigned long long int i = 0; i < 200000; ++i) {
+        row r;
+        r.city = cities[random() % 5];
+        if (random() % 17 != 0)
+            r.code = (long int) (random() % 40) - 20;
+        if (random() % 11 != 0)
+            r.v = double((long int) (random() % 4000) - 2000) / 4;
+        if (random() % 3 == 0)
+            r.w = double(random() % 100);
+        rows.emplace_back(r);
+    }
+    {
+        std::ofstream file("groups.csv", std::ios::trunc);
+        file << "city,code,v,w\n";
+        for (const auto &r : rows) {
+            file << r.city << ",";
+            if (r.code)
+                file << *r.code;
+            file << ",";
+            if (r.v)
+                file << *r.v;
+            file << ",";
+            if (r.w)
+                file << *r.w;
+            file << "\n";
+        }
+    }
+    const csv_schema schema = {{"city", category_column}, {"code", long_column}, {"v", double_column},
+                               {"w", double_column}};
+    dataframe<> frame("groups.csv", ',', 1, schema);
+    CHECK(frame.row_num() == rows.size());
+
+    // the groups in the order they first appear, each with the rows it holds
+    std::vector<std::vector<unsigned long long int>> groups;
+    for (unsigned long long int i = 0; i < rows.size(); ++i) {
+        unsigned long long int g = 0;
+        while (g < groups.size() &&
+               (rows[groups[g][0]].city != rows[i].city || rows[groups[g][0]].code != rows[i].code))
+            ++g;
+        if (g == groups.size())
+            groups.emplace_back();
+        groups[g].emplace_back(i);
+    }
+
+    const std::vector<std::pair<std::string, aggregate_type>> aggregates = {
+            {"v", sum_aggregate}, {"v", mean_aggregate}, {"w", count_aggregate}, {"w", min_aggregate},
+            {"w", max_aggregate}, {"v", std_aggregate}};
+    for (unsigned int threads : {1u, 4u}) {
+        auto grouped = frame.group_by({"city", "code"}).agg(aggregates, threads);
+        CHECK(grouped.get_column_str() ==
+              (std::vector<std::string>{"city", "code", "v_sum", "v_mean", "w_count", "w_min", "w_max", "v_std"}));
+        CHECK(grouped.row_num() == groups.size());
+        for (unsigned long long int g = 0; g < groups.size(); ++g) {
+            const row &first = rows[groups[g][0]];
+            CHECK(std::get<std::string>(grouped(0).get(g)) == first.city);
+            CHECK(grouped(1).is_null(g) == !first.code);
+            CHECK(!first.code || std::get<long int>(grouped(1).get(g)) == *first.code);
+
+            double sum = 0, count = 0, cells = 0, min = INFINITY, max = -INFINITY;
+            for (auto i : groups[g]) {
+                if (rows[i].v) {
+                    sum += *rows[i].v;
+                    ++count;
+                }
+                if (rows[i].w) {
+                    ++cells;
+                    min = std::min(min, *rows[i].w);
+                    max = std::max(max, *rows[i].w);
+                }
+            }
+            double mean = count == 0 ? NAN : sum / count, squares = 0;
+            for (auto i : groups[g]) {
+                if (rows[i].v)
+                    squares += (*rows[i].v - mean) * (*rows[i].v - mean);
+            }
+            double deviation = count < 2 ? NAN : std::sqrt(squares / (count - 1));
+            CHECK(close(std::get<double>(grouped(2).get(g)), sum));
+            CHECK(close(std::get<double>(grouped(3).get(g)), mean));
+            CHECK(std::get<double>(grouped(4).get(g)) == cells);
+            CHECK(close(std::get<double>(grouped(5).get(g)), cells == 0 ? NAN : min));
+            CHECK(close(std::get<double>(grouped(6).get(g)), cells == 0 ? NAN : max));
+            CHECK(close(std::get<double>(grouped(7).get(g)), deviation));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+// inner and left joins against a nested loop over the rows of both dataframes, with one and several threads
+
+#include <fstream>
+#include <optional>
+#include <random>
+#include "dataframe.hpp"
+#include "check.hpp"
+
+using namespace flame;
+
+struct row {
+    std::optional<long int> k;
+    std::string g;
+    std::string x;
+    double v = 0;
+};
+
+// rows with keys drawn from a small range so that many of them match, x is the number of the row
+static std::vector<row> make_rows(unsigned long long int count, std::mt19937_64 &random) {
+    const char *words[] = {"a", "b", "c"};
+    std::vector<row> rows;
+    for (unsigned long long int i = 0; i < count; ++i) {
+        row r;
+        if (random() % 29 != 0)
+            r.k = (long int) (random() % 300);
+        r.g = words[random() % 3];
+        r.x = "row" + std::to_string(i);
+        r.v = double(random() % 1000) / 8;
+        rows.emplace_back(r);
+    }
+    return rows;
+}
+
+static void write_rows(const std::string &filename, const std::vector<row> &rows, const std::string &x) {
+    std::ofstream file(filename, std::ios::trunc);
+    file << "k,g," << x << ",v\n";
+    for (const auto &r : rows) {
+        if (r.k)
+            file << *r.k;
+        file << "," << r.g << "," << r.x << "," << r.v << "\n";
+    }
+}
+
+// the left rows in order, each followed by the right rows it matches in order, and by nothing in a left join
+static void check_join(const std::vector<row> &left, const std::vector<row> &right, const dataframe<> &a,
+                       const dataframe<> &b) {
+    std::vector<std::vector<unsigned long long int>> matches(left.size());
+    for (unsigned long long int i = 0; i < left.size(); ++i) {
+        for (unsigned long long int j = 0; j < right.size(); ++j) {
+            if (left[i].k && right[j].k && *left[i].k == *right[j].k && left[i].g == right[j].g)
+                matches[i].emplace_back(j);
+        }
+    }
+    for (join_type how : {inner_join, left_join}) {
+        std::vector<std::pair<unsigned long long int, std::optional<unsigned long long int>>> expected;
+        for (unsigned long long int i = 0; i < left.size(); ++i) {
+            for (auto j : matches[i])
+                expected.emplace_back(i, j);
+            if (matches[i].empty() && how == left_join)
+                expected.emplace_back(i, std::nullopt);
+        }
+        for (unsigned int threads : {1u, 3u}) {
+            auto joined = a.join(b, {"k", "g"}, how, threads);
+            CHECK(joined.get_column_str() == (std::vector<std::string>{"k", "g", "x", "v", "y", "v_r"}));
+            CHECK(joined.row_num() == expected.size());
+            for (unsigned long long int n = 0; n < expected.size(); ++n) {
+                const row &l = left[expected[n].first];
+                CHECK(joined(0).is_null(n) == !l.k);
+                CHECK(!l.k || std::get<long int>(joined(0).get(n)) == *l.k);
+                CHECK(std::get<std::string>(joined(1).get(n)) == l.g);
+                CHECK(std::get<std::string>(joined(2).get(n)) == l.x);
+                CHECK(std::get<double>(joined(3).get(n)) == l.v);
+                if (expected[n].second) {
+                    const row &r = right[*expected[n].second];
+                    CHECK(std::get<std::string>(joined(4).get(n)) == r.x);
+                    CHECK(std::get<double>(joined(5).get(n)) == r.v);
+                } else CHECK(joined(4).is_null(n) && joined(5).is_null(n));
+            }
+        }
+    }
+}
+
+int main() {
+    std::mt19937_64 random(11);
+    // the keys are long on the left and int on the right, g is a string on the left and a category on the right
+    const csv_schema left_schema = {{"k", long_column}, {"g", string_column}, {"x", string_column},
+                                    {"v", double_column}};
+    const csv_schema right_schema = {{"k", int_column}, {"g", category_column}, {"y", string_column},
+                                     {"v", double_column}};
+    auto big = make_rows(140000, random), small = make_rows(400, random);
+    write_rows("big.csv", big, "x");
+    write_rows("small.csv", small, "x");
+    write_rows("big_right.csv", big, "y");
+    write_rows("small_right.csv", small, "y");
+
+    // a big dataframe probing a small one, then a small one whose rows are found by probing a big one
+    dataframe<> big_left("big.csv", ',', 1, left_schema), small_right("small_right.csv", ',', 1, right_schema);
+    dataframe<> small_left("small.csv", ',', 1, left_schema), big_right("big_right.csv", ',', 1, right_schema);
+    CHECK(big_right(0).type() == int_column && small_right(1).type() == category_column);
+    check_join(big, small, big_left, small_right);
+    check_join(small, big, small_left, big_right);
+    return 0;
+}
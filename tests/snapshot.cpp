@@ -0,0 +1,118 @@
+// save_binary then load_binary gives the same frame with its missing values, copied or mapped, a snapshot of the
+// first version is still read and every truncated snapshot is rejected
+
+#include "dataframe.hpp"
+#include "check.hpp"
+
+using namespace flame;
+
+// the frames hold the same columns of the same layout and the same cells in the same rows
+static void check_same(const dataframe<> &a, const dataframe<> &b) {
+    CHECK(a.get_column_str() == b.get_column_str());
+    CHECK(a.row_num() == b.row_num());
+    for (unsigned long long int j = 0; j < a.column_num(); ++j) {
+        CHECK(a(j).type() == b(j).type());
+        for (unsigned long long int i = 0; i < a.row_num(); ++i) {
+            CHECK(a(j).is_null(i) == b(j).is_null(i));
+            CHECK(a(j).is_null(i) || a(j).get(i) == b(j).get(i));
+        }
+    }
+}
+
+static std::string read_file(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+template<typename U>
+static void append_bytes(std::string &bytes, const U &value) {
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// a snapshot of the first version of the format, which has no validity bitmaps: a long column "a" holding
+// 1, 2, 3 and a string column "s" holding "x", "yz", ""
+static void write_first_version(const std::string &filename) {
+    std::string bytes("FLAMEDF1", 8);
+    append_bytes(bytes, 2ULL);
+    append_bytes(bytes, 3ULL);
+    // the header is the magic, the two counts and four numbers and the padded name per column
+    const unsigned long long int header = 8 + 2 * 8 + 2 * (4 * 8 + 8);
+    append_bytes(bytes, (unsigned long long int) long_column);
+    append_bytes(bytes, header);
+    append_bytes(bytes, 3 * 8ULL);
+    append_bytes(bytes, 1ULL);
+    bytes.append("a\0\0\0\0\0\0\0", 8);
+    append_bytes(bytes, (unsigned long long int) string_column);
+    append_bytes(bytes, header + 3 * 8);
+    append_bytes(bytes, 4 * 8ULL + 3);
+    append_bytes(bytes, 1ULL);
+    bytes.append("s\0\0\0\0\0\0\0", 8);
+    for (long int value : {1L, 2L, 3L})
+        append_bytes(bytes, value);
+    for (unsigned long long int offset : {0ULL, 1ULL, 3ULL, 3ULL})
+        append_bytes(bytes, offset);
+    bytes.append("xyz\0\0\0\0\0", 8);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), (std::streamsize) bytes.size());
+}
+
+int main() {
+    // the last column is a whole number of words, so that no padding follows it
+    dataframe<> frame(std::vector<std::string>{"name", "mixed", "price", "id"});
+    for (int i = 0; i < 1000; ++i) {
+        user_variant mixed = i % 3 == 0 ? user_variant("word" + std::to_string(i)) : user_variant(i);
+        frame.append({"name" + std::to_string(i % 7), mixed, i / 8.0, long(i)});
+    }
+    CHECK(frame(0).type() == string_column && frame(1).type() == cell_column);
+    CHECK(frame(2).type() == double_column && frame(3).type() == long_column);
+    for (unsigned long long int j = 0; j < frame.column_num(); ++j) {
+        for (unsigned long long int i = j; i < frame.row_num(); i += 13)
+            frame(j).set_null(i);
+    }
+
+    frame.save_binary("frame.bin");
+    for (bool mapped : {false, true}) {
+        dataframe<> loaded;
+        loaded.load_binary("frame.bin", mapped);
+        check_same(frame, loaded);
+    }
+
+    // the first version of the format is still read, every cell of it is valid
+    write_first_version("first.bin");
+    for (bool mapped : {false, true}) {
+        dataframe<> first;
+        first.load_binary("first.bin", mapped);
+        CHECK(first.get_column_str() == (std::vector<std::string>{"a", "s"}) && first.row_num() == 3);
+        CHECK(first(0).type() == long_column && first(1).type() == string_column);
+        CHECK(first(0).null_count() == 0 && first(1).null_count() == 0);
+        CHECK(std::get<long int>(first(0).get(2)) == 3 && std::get<std::string>(first(1).get(1)) == "yz");
+        CHECK(std::get<std::string>(first(1).get(2)).empty());
+    }
+
+    // an empty frame and an empty column
+    dataframe<> empty(std::vector<std::string>{"a"});
+    empty.save_binary("empty.bin");
+    dataframe<> loaded_empty;
+    loaded_empty.load_binary("empty.bin");
+    check_same(empty, loaded_empty);
+
+    // every truncation of the file is rejected, whether it cuts the header or a column
+    const std::string bytes = read_file("frame.bin");
+    for (unsigned long long int size = 0; size < bytes.size(); size += size < 256 ? 1 : 97) {
+        {
+            std::ofstream file("truncated.bin", std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), (std::streamsize) size);
+        }
+        for (bool mapped : {false, true}) {
+            bool rejected = false;
+            try {
+                dataframe<> loaded;
+                loaded.load_binary("truncated.bin", mapped);
+            } catch (std::invalid_argument &) {
+                rejected = true;
+            }
+            CHECK(rejected);
+        }
+    }
+    return 0;
+}
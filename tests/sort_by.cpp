@@ -0,0 +1,105 @@
+// sort_by on numbers, categories and strings against std::stable_sort, in both orders and with several threads
+
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <random>
+#include "dataframe.hpp"
+#include "check.hpp"
+
+using namespace flame;
+
+struct row {
+    long int id = 0;
+    std::optional<long int> l;
+    std::optional<double> d;
+    std::optional<std::string> c;
+    std::optional<std::string> s;
+};
+
+// -1, 0 or 1 as a goes before, with or after b, a missing value goes after every value in both orders
+template<typename U>
+static int compare(const std::optional<U> &a, const std::optional<U> &b, bool ascending) {
+    if (!a || !b)
+        return int(!a) - int(!b);
+    if (*a == *b)
+        return 0;
+    return (*a < *b) == ascending ? -1 : 1;
+}
+
+static int compare(const row &a, const row &b, const std::string &col, bool ascending) {
+    if (col == "l")
+        return compare(a.l, b.l, ascending);
+    if (col == "d")
+        return compare(a.d, b.d, ascending);
+    if (col == "c")
+        return compare(a.c, b.c, ascending);
+    return compare(a.s, b.s, ascending);
+}
+
+int main() {
+    // few distinct values so that there are many ties, id is the row before sorting
+    std::vector<row> rows;
+    std::mt19937_64 random(5);
+    const char *words[] = {"pear", "apple", "fig", "kiwi", "plum", "lime"};
+    for (long int i = 0; i < 100000; ++i) {
+        row r;
+        r.id = i;
+        if (random() % 13 != 0)
+            r.l = (long int) (random() % 200) - 100;
+        if (random() % 7 != 0)
+            r.d = double((long int) (random() % 8000) - 4000) / 8;
+        if (random() % 19 != 0)
+            r.c = words[random() % 6];
+        if (random() % 5 != 0)
+            r.s = std::string(words[random() % 6]) + std::to_string(random() % 50);
+        rows.emplace_back(r);
+    }
+    {
+        std::ofstream file("sort.csv", std::ios::trunc);
+        file << "id,l,d,c,s\n";
+        for (const auto &r : rows) {
+            file << r.id << ",";
+            if (r.l)
+                file << *r.l;
+            file << ",";
+            if (r.d)
+                file << *r.d;
+            file << "," << r.c.value_or("") << "," << r.s.value_or("") << "\n";
+        }
+    }
+    const csv_schema schema = {{"id", long_column}, {"l", long_column}, {"d", double_column},
+                               {"c", category_column}, {"s", string_column}};
+    const dataframe<> frame("sort.csv", ',', 1, schema);
+
+    const std::vector<std::vector<std::string>> keys = {{"l"}, {"d"}, {"c"}, {"s"}, {"c", "l", "d"}, {"s", "d"}};
+    for (const auto &cols : keys) {
+        for (bool ascending : {true, false}) {
+            std::vector<row> expected(rows);
+            std::stable_sort(expected.begin(), expected.end(), [&](const row &a, const row &b) {
+                for (const auto &col : cols) {
+                    int order = compare(a, b, col, ascending);
+                    if (order != 0)
+                        return order < 0;
+                }
+                return false;
+            });
+            for (unsigned int threads : {1u, 4u}) {
+                dataframe<> sorted(frame);
+                sorted.sort_by(cols, ascending, threads);
+                CHECK(sorted.row_num() == expected.size());
+                for (unsigned long long int i = 0; i < expected.size(); ++i) {
+                    const row &r = expected[i];
+                    CHECK(std::get<long int>(sorted(0).get(i)) == r.id);
+                    CHECK(sorted(1).is_null(i) == !r.l && (!r.l || std::get<long int>(sorted(1).get(i)) == *r.l));
+                    CHECK(sorted(2).is_null(i) == !r.d && (!r.d || std::get<double>(sorted(2).get(i)) == *r.d));
+                    CHECK(sorted(3).is_null(i) == !r.c &&
+                          (!r.c || std::get<std::string>(sorted(3).get(i)) == *r.c));
+                    CHECK(sorted(4).is_null(i) == !r.s &&
+                          (!r.s || std::get<std::string>(sorted(4).get(i)) == *r.s));
+                }
+            }
+        }
+    }
+    return 0;
+}